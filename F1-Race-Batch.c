@@ -0,0 +1,464 @@
+/*
+ * About:
+ *   Parallel batch simulation runner for the "F1 Race" game core, plays full games without window and audio.
+ *
+ * License:
+ *   MIT
+ *
+ * Compile commands:
+ *   $ gcc -O2 F1-Race-Batch.c F1-Race-Collision.c F1-Race-Core.c -o f1race-batch -lpthread
+ *   $ ./f1race-batch --games 1000000 --format csv --output results.csv
+ */
+
+#include "F1-Race-Core.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <time.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#define F1RACE_BATCH_DEFAULT_GAMES                     (100000)
+#define F1RACE_BATCH_DEFAULT_MAX_TICKS                 (100000)
+#define F1RACE_BATCH_MAX_THREADS                       (256)
+#define F1RACE_BATCH_CHUNK                             (64)
+#define F1RACE_BATCH_SINK_BUFFER                       (4096)
+#define F1RACE_BATCH_CACHE_LINE                        (64)
+#define F1RACE_BATCH_MAX_RULES_SIZE                    (65536)
+
+#define F1RACE_BATCH_RANGE(begin, end)                 (((uint64_t) (end) << 32) | (uint32_t) (begin))
+#define F1RACE_BATCH_RANGE_BEGIN(range)                ((uint32_t) (range))
+#define F1RACE_BATCH_RANGE_END(range)                  ((uint32_t) ((range) >> 32))
+
+typedef enum BATCH_FORMATS {
+	BATCH_FORMAT_CSV,
+	BATCH_FORMAT_BINARY,
+	BATCH_FORMAT_NONE
+} BATCH_FORMAT;
+
+typedef enum BATCH_POLICIES {
+	BATCH_POLICY_IDLE,
+	BATCH_POLICY_RANDOM
+} BATCH_POLICY;
+
+/* Binary sink record, written in host byte order after the "F1RB" file header. */
+typedef struct {
+	uint64_t seed;
+	uint32_t game;
+	uint32_t ticks;
+	int16_t score;
+	int16_t level;
+	int16_t fly_used;
+	int16_t reserved;
+} BATCH_RECORD;
+
+/* Range of game indices owned by a worker, the owner takes chunks from the front and thieves take halves from the back. */
+typedef struct {
+	_Atomic uint64_t range;
+	char padding[F1RACE_BATCH_CACHE_LINE - sizeof(uint64_t)];
+} BATCH_QUEUE;
+
+typedef struct {
+	pthread_t thread;
+	uint32_t id;
+	uint32_t random;
+	uint64_t games;
+	uint64_t ticks;
+	uint64_t steals;
+	uint32_t records_count;
+	BATCH_RECORD records[F1RACE_BATCH_SINK_BUFFER];
+	F1RACE_STATE state;
+} BATCH_WORKER;
+
+typedef struct {
+	uint32_t games;
+	uint32_t threads;
+	uint32_t max_ticks;
+	uint64_t seed;
+	BATCH_FORMAT format;
+	BATCH_POLICY policy;
+	const char *output;
+	F1RACE_TRAFFIC_CONFIG traffic;
+	const F1RACE_RULESET *rules;
+} BATCH_OPTIONS;
+
+static BATCH_OPTIONS options;
+static F1RACE_RULESET rules;
+static BATCH_QUEUE queues[F1RACE_BATCH_MAX_THREADS];
+static BATCH_WORKER *workers = NULL;
+
+static FILE *sink = NULL;
+static pthread_mutex_t sink_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static double Batch_Time(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static uint32_t Batch_Cpu_Count(void) {
+#if defined(_WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count > 0) ? (uint32_t) count : 1;
+#endif
+}
+
+static uint32_t Batch_Random(BATCH_WORKER *worker) {
+	uint32_t x = worker->random;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	worker->random = x;
+	return x;
+}
+
+static int Batch_Queue_Pop(BATCH_QUEUE *queue, uint32_t *begin, uint32_t *end) {
+	uint64_t range = atomic_load_explicit(&queue->range, memory_order_acquire);
+	for (;;) {
+		uint32_t b = F1RACE_BATCH_RANGE_BEGIN(range);
+		uint32_t e = F1RACE_BATCH_RANGE_END(range);
+		uint32_t n;
+		if (b >= e)
+			return 0;
+		n = (e - b < F1RACE_BATCH_CHUNK) ? e - b : F1RACE_BATCH_CHUNK;
+		if (atomic_compare_exchange_weak_explicit(&queue->range, &range, F1RACE_BATCH_RANGE(b + n, e),
+				memory_order_acq_rel, memory_order_acquire)) {
+			*begin = b;
+			*end = b + n;
+			return 1;
+		}
+	}
+}
+
+static int Batch_Queue_Steal(BATCH_QUEUE *queue, uint32_t *begin, uint32_t *end) {
+	uint64_t range = atomic_load_explicit(&queue->range, memory_order_acquire);
+	for (;;) {
+		uint32_t b = F1RACE_BATCH_RANGE_BEGIN(range);
+		uint32_t e = F1RACE_BATCH_RANGE_END(range);
+		uint32_t half;
+		if (b >= e || e - b < 2)
+			return 0;
+		half = (e - b) / 2;
+		if (atomic_compare_exchange_weak_explicit(&queue->range, &range, F1RACE_BATCH_RANGE(b, e - half),
+				memory_order_acq_rel, memory_order_acquire)) {
+			*begin = e - half;
+			*end = e;
+			return 1;
+		}
+	}
+}
+
+static void Batch_Sink_Flush(BATCH_WORKER *worker) {
+	uint32_t index;
+	BATCH_RECORD *record;
+
+	if (worker->records_count == 0)
+		return;
+
+	if (sink != NULL) {
+		pthread_mutex_lock(&sink_mutex);
+		if (options.format == BATCH_FORMAT_BINARY)
+			fwrite(worker->records, sizeof(BATCH_RECORD), worker->records_count, sink);
+		else
+			for (index = 0; index < worker->records_count; index++) {
+				record = &worker->records[index];
+				fprintf(sink, "%u,%llu,%d,%d,%u,%d\n", record->game, (unsigned long long) record->seed,
+					record->score, record->level, record->ticks, record->fly_used);
+			}
+		pthread_mutex_unlock(&sink_mutex);
+	}
+	worker->records_count = 0;
+}
+
+static uint8_t Batch_Policy(BATCH_WORKER *worker, uint8_t input) {
+	uint32_t random;
+
+	switch (options.policy) {
+		case BATCH_POLICY_RANDOM:
+			random = Batch_Random(worker);
+			if ((random & 7) == 0)
+				input = (random >> 8) % 5 ? (1 << ((random >> 12) & 3)) : 0;
+			else
+				input &= F1RACE_INPUT_DIRECTIONS;
+			if (((random >> 16) & 63) == 0)
+				input |= F1RACE_INPUT_FLY;
+			return input;
+		case BATCH_POLICY_IDLE:
+		default:
+			return 0;
+	}
+}
+
+static void Batch_Play(BATCH_WORKER *worker, uint32_t game) {
+	F1RACE_STATE *state = &worker->state;
+	BATCH_RECORD *record;
+	uint32_t events;
+	uint32_t ticks = 0;
+	int16_t fly_used = 0;
+	uint8_t input = 0;
+	uint64_t seed = options.seed + game;
+
+	worker->random = (uint32_t) (seed ^ (seed >> 32)) * 2654435761u;
+	if (worker->random == 0)
+		worker->random = 1;
+
+	F1Race_Seed(state, seed);
+	F1Race_Configure(state, &options.traffic);
+	F1Race_Set_Rules(state, options.rules);
+	F1Race_Init(state);
+	while (ticks < options.max_ticks) {
+		input = Batch_Policy(worker, input);
+		events = F1Race_Step(state, input);
+		ticks++;
+		if (events & F1RACE_EVENT_FLY)
+			fly_used++;
+		if (events & F1RACE_EVENT_CRASH)
+			break;
+	}
+
+	worker->games++;
+	worker->ticks += ticks;
+
+	if (options.format == BATCH_FORMAT_NONE)
+		return;
+
+	record = &worker->records[worker->records_count++];
+	record->seed = seed;
+	record->game = game;
+	record->ticks = ticks;
+	record->score = state->score;
+	record->level = state->level;
+	record->fly_used = fly_used;
+	record->reserved = 0;
+	if (worker->records_count == F1RACE_BATCH_SINK_BUFFER)
+		Batch_Sink_Flush(worker);
+}
+
+static void *Batch_Worker(void *argument) {
+	BATCH_WORKER *worker = argument;
+	uint32_t begin = 0, end = 0, game, victim, index;
+	BATCH_QUEUE *queue = &queues[worker->id];
+
+	for (;;) {
+		while (Batch_Queue_Pop(queue, &begin, &end))
+			for (game = begin; game < end; game++)
+				Batch_Play(worker, game);
+
+		for (index = 1; index < options.threads; index++) {
+			victim = (worker->id + index) % options.threads;
+			if (Batch_Queue_Steal(&queues[victim], &begin, &end))
+				break;
+		}
+		if (index == options.threads)
+			break;
+
+		worker->steals++;
+		atomic_store_explicit(&queue->range, F1RACE_BATCH_RANGE(begin, end), memory_order_release);
+	}
+
+	Batch_Sink_Flush(worker);
+	return NULL;
+}
+
+static void Batch_Usage(const char *program) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -g, --games N        number of games to play (default: %d)\n"
+		"  -j, --threads N      number of worker threads (default: all cores)\n"
+		"  -t, --max-ticks N    stop a game after N ticks (default: %d)\n"
+		"  -s, --seed N         seed of the first game, game K uses seed N + K (default: 0)\n"
+		"  -p, --policy NAME    input policy: idle, random (default: random)\n"
+		"  -f, --format NAME    result format: csv, bin, none (default: csv)\n"
+		"  -o, --output FILE    result file (default: stdout)\n"
+		"  -T, --traffic L,C[,D[,S]]  stress traffic: lanes up to %d, cars up to %d, depth, spawns per tick,\n"
+		"                       more cars need a \"make build-batch-stress\" or \"TRAFFIC=\" build\n"
+		"  -R, --rules FILE     car types, spawn weights and levels (default: classic)\n",
+		program, F1RACE_BATCH_DEFAULT_GAMES, F1RACE_BATCH_DEFAULT_MAX_TICKS, F1RACE_MAX_LANES,
+		F1RACE_OPPOSITE_CAR_COUNT);
+}
+
+/* Rules of all games, the classic ones changed by the settings of the file. */
+static int Batch_Load_Rules(const char *path) {
+	static char text[F1RACE_BATCH_MAX_RULES_SIZE];
+	F1RACE_RULES source;
+	size_t size;
+	int line;
+	FILE *file = fopen(path, "rb");
+	if (!file) {
+		fprintf(stderr, "Cannot open rules file: %s.\n", path);
+		return 0;
+	}
+	size = fread(text, 1, sizeof(text), file);
+	fclose(file);
+	if (size == sizeof(text)) {
+		fprintf(stderr, "Rules file is larger than %d bytes: %s.\n", F1RACE_BATCH_MAX_RULES_SIZE - 1, path);
+		return 0;
+	}
+	F1Race_Rules_Classic(&source);
+	line = F1Race_Rules_Parse(&source, text, size);
+	if (line != 0) {
+		fprintf(stderr, "Wrong rules: %s, line %d.\n", path, line);
+		return 0;
+	}
+	if (!F1Race_Rules_Compile(&rules, &source)) {
+		fprintf(stderr, "Rules cannot be played: %s.\n", path);
+		return 0;
+	}
+	options.rules = &rules;
+	return 1;
+}
+
+static int Batch_Parse_Options(int argc, char *argv[]) {
+	int index;
+	const char *value;
+	F1RACE_TRAFFIC_ERROR error;
+
+	options.games = F1RACE_BATCH_DEFAULT_GAMES;
+	options.threads = Batch_Cpu_Count();
+	options.max_ticks = F1RACE_BATCH_DEFAULT_MAX_TICKS;
+	options.seed = 0;
+	options.format = BATCH_FORMAT_CSV;
+	options.policy = BATCH_POLICY_RANDOM;
+	options.output = NULL;
+	F1Race_Traffic_Classic(&options.traffic);
+	options.rules = F1Race_Ruleset_Classic();
+
+	for (index = 1; index < argc; index++) {
+		if (!strcmp(argv[index], "-h") || !strcmp(argv[index], "--help"))
+			return 0;
+		if (index + 1 >= argc) {
+			fprintf(stderr, "Missing value for option: %s.\n", argv[index]);
+			return 0;
+		}
+		value = argv[++index];
+		if (!strcmp(argv[index - 1], "-g") || !strcmp(argv[index - 1], "--games"))
+			options.games = strtoul(value, NULL, 10);
+		else if (!strcmp(argv[index - 1], "-j") || !strcmp(argv[index - 1], "--threads"))
+			options.threads = strtoul(value, NULL, 10);
+		else if (!strcmp(argv[index - 1], "-t") || !strcmp(argv[index - 1], "--max-ticks"))
+			options.max_ticks = strtoul(value, NULL, 10);
+		else if (!strcmp(argv[index - 1], "-s") || !strcmp(argv[index - 1], "--seed"))
+			options.seed = strtoull(value, NULL, 10);
+		else if (!strcmp(argv[index - 1], "-o") || !strcmp(argv[index - 1], "--output"))
+			options.output = value;
+		else if (!strcmp(argv[index - 1], "-T") || !strcmp(argv[index - 1], "--traffic")) {
+			error = F1Race_Traffic_Parse(&options.traffic, value);
+			if (error != F1RACE_TRAFFIC_OK) {
+				fprintf(stderr, "Wrong traffic: %s, %s, this build takes 1-%d lanes, 1-%d cars, depth 0-%d and "
+					"1-%d spawns.\n", value, F1Race_Traffic_Error(error), F1RACE_MAX_LANES, F1RACE_OPPOSITE_CAR_COUNT,
+					F1RACE_MAX_TRAFFIC_DEPTH, F1RACE_MAX_LANES);
+				if (error == F1RACE_TRAFFIC_CARS)
+					fprintf(stderr, "Build with TRAFFIC=-DF1RACE_OPPOSITE_CAR_COUNT=N for more cars.\n");
+				return 0;
+			}
+		} else if (!strcmp(argv[index - 1], "-R") || !strcmp(argv[index - 1], "--rules")) {
+			if (!Batch_Load_Rules(value))
+				return 0;
+		} else if (!strcmp(argv[index - 1], "-p") || !strcmp(argv[index - 1], "--policy")) {
+			if (!strcmp(value, "idle"))
+				options.policy = BATCH_POLICY_IDLE;
+			else if (!strcmp(value, "random"))
+				options.policy = BATCH_POLICY_RANDOM;
+			else {
+				fprintf(stderr, "Unknown policy: %s.\n", value);
+				return 0;
+			}
+		} else if (!strcmp(argv[index - 1], "-f") || !strcmp(argv[index - 1], "--format")) {
+			if (!strcmp(value, "csv"))
+				options.format = BATCH_FORMAT_CSV;
+			else if (!strcmp(value, "bin"))
+				options.format = BATCH_FORMAT_BINARY;
+			else if (!strcmp(value, "none"))
+				options.format = BATCH_FORMAT_NONE;
+			else {
+				fprintf(stderr, "Unknown format: %s.\n", value);
+				return 0;
+			}
+		} else {
+			fprintf(stderr, "Unknown option: %s.\n", argv[index - 1]);
+			return 0;
+		}
+	}
+
+	if (options.threads < 1)
+		options.threads = 1;
+	if (options.threads > F1RACE_BATCH_MAX_THREADS)
+		options.threads = F1RACE_BATCH_MAX_THREADS;
+	return 1;
+}
+
+int main(int argc, char *argv[]) {
+	uint32_t index;
+	uint32_t begin, end;
+	uint64_t games = 0, ticks = 0, steals = 0;
+	double start, elapsed;
+
+	if (!Batch_Parse_Options(argc, argv)) {
+		Batch_Usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (options.format != BATCH_FORMAT_NONE) {
+		sink = (options.output) ? fopen(options.output, (options.format == BATCH_FORMAT_BINARY) ? "wb" : "w") : stdout;
+		if (sink == NULL) {
+			fprintf(stderr, "Cannot open output file: %s.\n", options.output);
+			return EXIT_FAILURE;
+		}
+		if (options.format == BATCH_FORMAT_BINARY) {
+			uint32_t record_size = sizeof(BATCH_RECORD);
+			fwrite("F1RB", 1, 4, sink);
+			fwrite(&record_size, sizeof(record_size), 1, sink);
+		} else
+			fprintf(sink, "game,seed,score,level,ticks,fly_used\n");
+	}
+
+	workers = calloc(options.threads, sizeof(BATCH_WORKER));
+	if (workers == NULL) {
+		fprintf(stderr, "Cannot allocate %u workers.\n", options.threads);
+		return EXIT_FAILURE;
+	}
+
+	for (index = 0; index < options.threads; index++) {
+		begin = (uint32_t) ((uint64_t) options.games * index / options.threads);
+		end = (uint32_t) ((uint64_t) options.games * (index + 1) / options.threads);
+		atomic_init(&queues[index].range, F1RACE_BATCH_RANGE(begin, end));
+		workers[index].id = index;
+	}
+
+	start = Batch_Time();
+	for (index = 0; index < options.threads; index++)
+		if (pthread_create(&workers[index].thread, NULL, Batch_Worker, &workers[index]) != 0) {
+			fprintf(stderr, "Cannot create worker thread %u.\n", index);
+			return EXIT_FAILURE;
+		}
+	for (index = 0; index < options.threads; index++) {
+		pthread_join(workers[index].thread, NULL);
+		games += workers[index].games;
+		ticks += workers[index].ticks;
+		steals += workers[index].steals;
+	}
+	elapsed = Batch_Time() - start;
+
+	if (sink != NULL && sink != stdout)
+		fclose(sink);
+	free(workers);
+
+	fprintf(stderr, "Games: %llu, ticks: %llu, threads: %u, steals: %llu, time: %.3f s.\n",
+		(unsigned long long) games, (unsigned long long) ticks, options.threads, (unsigned long long) steals, elapsed);
+	fprintf(stderr, "Throughput: %.0f games/sec, %.0f ticks/sec.\n", games / elapsed, ticks / elapsed);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,861 @@
+/*
+ * About:
+ *   Micro-benchmarks of the "F1 Race" game modules, runs without window and audio.
+ *
+ * License:
+ *   MIT
+ *
+ * Compile commands:
+ *   $ gcc -O2 F1-Race-Bench.c F1-Race-Collision.c F1-Race-Core.c F1-Race-Draw.c F1-Race-Framebuffer.c F1-Race-Snapshot.c -o f1race-bench
+ *   $ ./f1race-bench --filter blit
+ *   $ ./f1race-bench --filter logic --frames 1000000 --repetitions 20
+ */
+
+#include "F1-Race-Collision.h"
+#include "F1-Race-Core.h"
+#include "F1-Race-Draw.h"
+#include "F1-Race-Framebuffer.h"
+#include "F1-Race-Snapshot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <time.h>
+
+#define F1RACE_BENCH_DEFAULT_FRAMES                    (100000)
+#define F1RACE_BENCH_SCREEN_WIDTH                      (128)
+#define F1RACE_BENCH_SCREEN_HEIGHT                     (128)
+#define F1RACE_BENCH_ATLAS_WIDTH                       (128)
+#define F1RACE_BENCH_ATLAS_HEIGHT                      (160)
+#define F1RACE_BENCH_SPRITES                           (11)
+#define F1RACE_BENCH_DIGITS                            (4)
+#define F1RACE_BENCH_DEFAULT_REPETITIONS               (10)
+#define F1RACE_BENCH_DEFAULT_WARMUP                    (2)
+#define F1RACE_BENCH_MAX_REPETITIONS                   (100)
+#define F1RACE_BENCH_LAYOUTS                           (1024)
+#define F1RACE_BENCH_BATCH                             (64)
+#define F1RACE_BENCH_INPUTS                            (4096)
+#define F1RACE_BENCH_BOX_GROUPS                        (4096)
+#define F1RACE_BENCH_REWIND                            (256)
+#define F1RACE_BENCH_REWIND_ROUNDS                     (64)
+
+typedef struct {
+	const char *name;
+	void (*run)(void);
+} BENCH_CASE;
+
+typedef void (*BENCH_PHASE)(F1RACE_STATE *state);
+
+typedef struct {
+	uint32_t frames;
+	uint32_t repetitions;
+	uint32_t warmup;
+	uint32_t seed;
+	const char *filter;
+	F1RACE_TRAFFIC_CONFIG traffic;
+} BENCH_OPTIONS;
+
+static BENCH_OPTIONS options;
+
+static double Bench_Time(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static uint32_t Bench_Random(uint32_t *state) {
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+static uint32_t Bench_Hash(const uint32_t *pixels, uint32_t count, uint32_t hash) {
+	uint32_t index;
+	for (index = 0; index < count; index++)
+		hash = (hash ^ pixels[index]) * 16777619u;
+	return hash;
+}
+
+/* Sprite sizes of the game: opposite cars, player car, fly sprite and a status digit. */
+static const int16_t bench_sprite_sizes[F1RACE_BENCH_SPRITES][2] = {
+	{ F1RACE_OPPOSITE_CAR_0_IMAGE_SIZE_X, F1RACE_OPPOSITE_CAR_0_IMAGE_SIZE_Y },
+	{ F1RACE_OPPOSITE_CAR_1_IMAGE_SIZE_X, F1RACE_OPPOSITE_CAR_1_IMAGE_SIZE_Y },
+	{ F1RACE_OPPOSITE_CAR_2_IMAGE_SIZE_X, F1RACE_OPPOSITE_CAR_2_IMAGE_SIZE_Y },
+	{ F1RACE_OPPOSITE_CAR_3_IMAGE_SIZE_X, F1RACE_OPPOSITE_CAR_3_IMAGE_SIZE_Y },
+	{ F1RACE_OPPOSITE_CAR_4_IMAGE_SIZE_X, F1RACE_OPPOSITE_CAR_4_IMAGE_SIZE_Y },
+	{ F1RACE_OPPOSITE_CAR_5_IMAGE_SIZE_X, F1RACE_OPPOSITE_CAR_5_IMAGE_SIZE_Y },
+	{ F1RACE_OPPOSITE_CAR_6_IMAGE_SIZE_X, F1RACE_OPPOSITE_CAR_6_IMAGE_SIZE_Y },
+	{ F1RACE_PLAYER_CAR_IMAGE_SIZE_X, F1RACE_PLAYER_CAR_IMAGE_SIZE_Y },
+	{ F1RACE_PLAYER_CAR_FLY_IMAGE_SIZE_X, F1RACE_PLAYER_CAR_FLY_IMAGE_SIZE_Y },
+	{ F1RACE_PLAYER_CAR_CARSH_IMAGE_SIZE_X, F1RACE_PLAYER_CAR_CARSH_IMAGE_SIZE_Y },
+	{ F1RACE_STATUS_NUMBER_WIDTH, F1RACE_STATUS_NUBBER_HEIGHT }
+};
+
+static uint32_t bench_atlas_pixels[F1RACE_BENCH_ATLAS_WIDTH * F1RACE_BENCH_ATLAS_HEIGHT];
+static F1RACE_DRAW_RECT bench_atlas_rects[F1RACE_BENCH_SPRITES];
+static uint32_t bench_screen[F1RACE_BENCH_SCREEN_WIDTH * F1RACE_BENCH_SCREEN_HEIGHT];
+
+/* Packs random opaque sprites with transparent corners and about a fifth of transparent pixels like the assets. */
+static void Bench_Atlas_Create(F1RACE_FRAMEBUFFER_ATLAS *atlas) {
+	uint32_t random = 0x2545F491u;
+	int16_t x = 0, y = 0, shelf = 0, i, j, k;
+	uint32_t pixel;
+	for (k = 0; k < F1RACE_BENCH_SPRITES; k++) {
+		F1RACE_DRAW_RECT *rect = &bench_atlas_rects[k];
+		rect->w = bench_sprite_sizes[k][0];
+		rect->h = bench_sprite_sizes[k][1];
+		if (x + rect->w > F1RACE_BENCH_ATLAS_WIDTH) {
+			x = 0;
+			y += shelf + 1;
+			shelf = 0;
+		}
+		rect->x = x;
+		rect->y = y;
+		x += rect->w + 1;
+		if (rect->h > shelf)
+			shelf = rect->h;
+		for (j = 0; j < rect->h; j++)
+			for (i = 0; i < rect->w; i++) {
+				pixel = Bench_Random(&random) | 0xFF;
+				if ((i < 2 || i >= rect->w - 2) && (j < 3 || j >= rect->h - 3))
+					pixel &= ~0xFFu;
+				else if (Bench_Random(&random) % 10 == 0)
+					pixel &= ~0xFFu;
+				bench_atlas_pixels[(rect->y + j) * F1RACE_BENCH_ATLAS_WIDTH + rect->x + i] = pixel;
+			}
+	}
+	atlas->pixels = bench_atlas_pixels;
+	atlas->pitch = F1RACE_BENCH_ATLAS_WIDTH;
+	atlas->rects = bench_atlas_rects;
+}
+
+static int32_t Bench_Clipped_Area(const F1RACE_DRAW_RECT *clip, int16_t x, int16_t y, int16_t w, int16_t h) {
+	int32_t x0 = (x > clip->x) ? x : clip->x;
+	int32_t y0 = (y > clip->y) ? y : clip->y;
+	int32_t x1 = (x + w < clip->x + clip->w) ? x + w : clip->x + clip->w;
+	int32_t y1 = (y + h < clip->y + clip->h) ? y + h : clip->y + clip->h;
+	return (x0 < x1 && y0 < y1) ? (x1 - x0) * (y1 - y0) : 0;
+}
+
+/*
+ * One frame of the software path: cars and the player car clipped to the road like F1Race_Render(), score
+ * digits clipped to the status panel. Cars enter and leave the road, so partially clipped rows are covered.
+ */
+static uint64_t Bench_Blit_Frame(F1RACE_FRAMEBUFFER *framebuffer, const F1RACE_FRAMEBUFFER_ATLAS *atlas,
+		const F1RACE_DRAW_RECT *road, const F1RACE_DRAW_RECT *status, uint32_t *random) {
+	uint64_t pixels = 0;
+	uint16_t image;
+	int16_t x, y, k;
+
+	F1Race_Framebuffer_Clip(framebuffer, road);
+	for (k = 0; k < F1RACE_CLASSIC_CARS + 1; k++) {
+		image = (k < F1RACE_CLASSIC_CARS) ? Bench_Random(random) % F1RACE_OPPOSITE_CAR_TYPE_COUNT :
+			F1RACE_OPPOSITE_CAR_TYPE_COUNT + Bench_Random(random) % 3;
+		x = road->x - 4 + Bench_Random(random) % (road->w + 8 - atlas->rects[image].w);
+		y = road->y - atlas->rects[image].h + Bench_Random(random) % (road->h + atlas->rects[image].h);
+		F1Race_Framebuffer_Blit(framebuffer, atlas, image, x, y);
+		pixels += Bench_Clipped_Area(&framebuffer->clip, x, y, atlas->rects[image].w, atlas->rects[image].h);
+	}
+
+	F1Race_Framebuffer_Clip(framebuffer, status);
+	image = F1RACE_BENCH_SPRITES - 1;
+	for (k = 0; k < F1RACE_BENCH_DIGITS; k++) {
+		x = status->x + 25 - k * 5;
+		y = status->y + 52;
+		F1Race_Framebuffer_Blit(framebuffer, atlas, image, x, y);
+		pixels += Bench_Clipped_Area(&framebuffer->clip, x, y, atlas->rects[image].w, atlas->rects[image].h);
+	}
+	return pixels;
+}
+
+static void Bench_Blit(void) {
+	F1RACE_FRAMEBUFFER framebuffer;
+	F1RACE_FRAMEBUFFER_ATLAS atlas;
+	F1RACE_DRAW_RECT road, status;
+	uint32_t kernel, frame, random, hash, reference = 0;
+	uint64_t pixels;
+	double start, elapsed;
+
+	road.x = F1RACE_ROAD_0_START_X;
+	road.y = F1RACE_DISPLAY_START_Y;
+	road.w = F1RACE_ROAD_2_END_X + 1 - road.x;
+	road.h = F1RACE_DISPLAY_END_Y - road.y;
+	status.x = F1RACE_STATUS_START_X;
+	status.y = F1RACE_DISPLAY_START_Y;
+	status.w = F1RACE_STATUS_END_X + 1 - status.x;
+	status.h = F1RACE_DISPLAY_END_Y - status.y;
+
+	Bench_Atlas_Create(&atlas);
+	F1Race_Framebuffer_Init(&framebuffer, bench_screen, F1RACE_BENCH_SCREEN_WIDTH, F1RACE_BENCH_SCREEN_HEIGHT);
+
+	for (kernel = 0; kernel < F1RACE_FRAMEBUFFER_KERNEL_COUNT; kernel++) {
+		if (!F1Race_Framebuffer_Set_Kernel(&framebuffer, kernel)) {
+			printf("blit/%-12s not available\n", F1Race_Framebuffer_Kernel_Name(kernel));
+			continue;
+		}
+
+		/* Same sprite positions for every kernel, results are compared with the scalar kernel. */
+		random = options.seed;
+		hash = 2166136261u;
+		pixels = 0;
+		F1Race_Framebuffer_Clip(&framebuffer, NULL);
+		F1Race_Framebuffer_Clear(&framebuffer, F1RACE_DRAW_RGB(150, 150, 150));
+		start = Bench_Time();
+		for (frame = 0; frame < options.frames; frame++) {
+			pixels += Bench_Blit_Frame(&framebuffer, &atlas, &road, &status, &random);
+			if ((frame & 1023) == 0)
+				hash = Bench_Hash(bench_screen, F1RACE_BENCH_SCREEN_WIDTH * F1RACE_BENCH_SCREEN_HEIGHT, hash);
+		}
+		elapsed = Bench_Time() - start;
+		hash = Bench_Hash(bench_screen, F1RACE_BENCH_SCREEN_WIDTH * F1RACE_BENCH_SCREEN_HEIGHT, hash);
+		if (kernel == F1RACE_FRAMEBUFFER_KERNEL_SCALAR)
+			reference = hash;
+
+		printf("blit/%-12s %10.1f Mpixels/sec %10.1f ns/frame %s\n", F1Race_Framebuffer_Kernel_Name(kernel),
+			pixels / elapsed / 1e6, elapsed * 1e9 / options.frames, (hash == reference) ? "ok" : "MISMATCH");
+	}
+}
+
+static F1RACE_STATE bench_layouts[F1RACE_BENCH_LAYOUTS];
+static F1RACE_STATE bench_batch[F1RACE_BENCH_BATCH];
+static uint8_t bench_inputs[F1RACE_BENCH_INPUTS];
+
+/*
+ * Random mid-game state: level, held keys, player car in the lower half of the road and from none to all
+ * opposite car slots taken by cars of any type anywhere from above the screen to its bottom edge. Boards are
+ * left dirty like after a tick.
+ */
+static void Bench_Layout_Create(F1RACE_STATE *state, uint32_t index, uint32_t *random) {
+	const F1RACE_OPPOSITE_CAR_TYPE_STRUCT *type;
+	F1RACE_TRAFFIC *traffic = &state->traffic;
+	F1RACE_CAR_STRUCT *player = &state->player_car;
+	uint32_t occupancy;
+	int16_t k;
+
+	F1Race_Seed(state, (uint64_t) options.seed * F1RACE_BENCH_LAYOUTS + index);
+	F1Race_Init(state);
+	state->level = 1 + Bench_Random(random) % 9;
+	state->keys = Bench_Random(random) & F1RACE_INPUT_DIRECTIONS;
+	state->last_car_road = Bench_Random(random) % 3;
+	player->pos_x = F1RACE_ROAD_0_START_X + Bench_Random(random) % (F1RACE_ROAD_2_END_X - F1RACE_ROAD_0_START_X - player->dx);
+	player->pos_y = (F1RACE_DISPLAY_START_Y + F1RACE_DISPLAY_END_Y) / 2 +
+		Bench_Random(random) % ((F1RACE_DISPLAY_END_Y - F1RACE_DISPLAY_START_Y) / 2 - player->dy);
+
+	occupancy = Bench_Random(random) % (F1RACE_CLASSIC_CARS + 1);
+	for (k = 0; k < F1RACE_CLASSIC_CARS; k++) {
+		if (Bench_Random(random) % F1RACE_CLASSIC_CARS >= occupancy)
+			continue;
+		type = &state->ruleset->types[Bench_Random(random) % F1RACE_OPPOSITE_CAR_TYPE_COUNT];
+		traffic->dx[k] = type->dx;
+		traffic->dy[k] = type->dy;
+		traffic->speed[k] = type->speed + state->ruleset->speed_bonus[state->level];
+		traffic->image[k] = type->image;
+		traffic->road_id[k] = Bench_Random(random) % 3;
+		traffic->pos_x[k] = traffic->lane_x[traffic->road_id[k]] + (F1RACE_ROAD_WIDTH - type->dx) / 2;
+		traffic->pos_y[k] = F1RACE_DISPLAY_START_Y - type->dy + Bench_Random(random) % (F1RACE_DISPLAY_END_Y - F1RACE_DISPLAY_START_Y + type->dy);
+		traffic->active[k >> 6] |= 1ull << (k & 63);
+		if (traffic->pos_y[k] > player->pos_y + player->dy)
+			traffic->scored[k >> 6] |= 1ull << (k & 63);
+	}
+}
+
+/* Held keys change every few ticks like a player steering, fly is requested now and then. */
+static void Bench_Logic_Create(void) {
+	uint32_t random = options.seed, index;
+	uint8_t keys = 0;
+	for (index = 0; index < F1RACE_BENCH_LAYOUTS; index++)
+		Bench_Layout_Create(&bench_layouts[index], index, &random);
+	for (index = 0; index < F1RACE_BENCH_INPUTS; index++) {
+		if (Bench_Random(&random) % 8 == 0)
+			keys = Bench_Random(&random) & F1RACE_INPUT_DIRECTIONS;
+		bench_inputs[index] = keys | ((Bench_Random(&random) % 64 == 0) ? F1RACE_INPUT_FLY : 0);
+	}
+}
+
+/* Every call gets a fresh layout: batches are copied outside of the timed loop, which only calls the phase. */
+static double Bench_Phase_Run(BENCH_PHASE phase) {
+	uint32_t done = 0, layout = 0, count, index;
+	double start, elapsed = 0.0;
+	while (done < options.frames) {
+		count = (options.frames - done < F1RACE_BENCH_BATCH) ? options.frames - done : F1RACE_BENCH_BATCH;
+		memcpy(bench_batch, &bench_layouts[layout], count * sizeof(F1RACE_STATE));
+		layout = (layout + F1RACE_BENCH_BATCH) % F1RACE_BENCH_LAYOUTS;
+		start = Bench_Time();
+		for (index = 0; index < count; index++)
+			phase(&bench_batch[index]);
+		elapsed += Bench_Time() - start;
+		done += count;
+	}
+	return elapsed;
+}
+
+/* Median and range of nanoseconds per operation over the repetitions, warm-up runs are not included. */
+static void Bench_Report(const char *name, const char *unit, double *samples, uint32_t count) {
+	uint32_t index, j;
+	double swap, median;
+	for (index = 1; index < count; index++)
+		for (j = index; j > 0 && samples[j] < samples[j - 1]; j--) {
+			swap = samples[j];
+			samples[j] = samples[j - 1];
+			samples[j - 1] = swap;
+		}
+	median = (count % 2) ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) / 2.0;
+	printf("logic/%-12s %10.2f ns/%-4s %12.0f %s/sec   min %.2f max %.2f ns/%s, %u runs\n", name, median, unit,
+		1e9 / median, unit, samples[0], samples[count - 1], unit, count);
+}
+
+static void Bench_Phase(const char *name, BENCH_PHASE phase) {
+	double samples[F1RACE_BENCH_MAX_REPETITIONS];
+	uint32_t run;
+	for (run = 0; run < options.warmup; run++)
+		Bench_Phase_Run(phase);
+	for (run = 0; run < options.repetitions; run++)
+		samples[run] = Bench_Phase_Run(phase) * 1e9 / options.frames;
+	Bench_Report(name, "op", samples, options.repetitions);
+}
+
+static void Bench_Logic_Collision(void) {
+	Bench_Logic_Create();
+	Bench_Phase("collision", F1Race_CollisionCheck);
+}
+
+static void Bench_Logic_New_Car(void) {
+	Bench_Logic_Create();
+	Bench_Phase("new_car", F1Race_New_Opposite_Car);
+}
+
+static void Bench_Logic_Framemove(void) {
+	Bench_Logic_Create();
+	Bench_Phase("framemove", F1Race_Framemove);
+}
+
+/*
+ * Whole games through F1Race_Step() including crashes, countdowns and restarts, the game goes on across runs.
+ * The only case which plays the "--traffic" configuration.
+ */
+static void Bench_Logic_Tick(void) {
+	double samples[F1RACE_BENCH_MAX_REPETITIONS];
+	F1RACE_STATE state;
+	uint32_t run, tick, input = 0, games = 0;
+	double start;
+
+	Bench_Logic_Create();
+	F1Race_Seed(&state, options.seed);
+	F1Race_Configure(&state, &options.traffic);
+	F1Race_Init(&state);
+	for (run = 0; run < options.warmup + options.repetitions; run++) {
+		start = Bench_Time();
+		for (tick = 0; tick < options.frames; tick++) {
+			if (F1Race_Step(&state, bench_inputs[input++ & (F1RACE_BENCH_INPUTS - 1)]) & F1RACE_EVENT_NEW_GAME)
+				games++;
+		}
+		if (run >= options.warmup)
+			samples[run - options.warmup] = (Bench_Time() - start) * 1e9 / options.frames;
+	}
+	Bench_Report("tick", "tick", samples, options.repetitions);
+	printf("logic/%-12s %u games finished, %.0f ticks per game\n", "tick", games,
+		games ? (double) (options.warmup + options.repetitions) * options.frames / games : 0.0);
+}
+
+static F1RACE_COLLISION_BOXES bench_box_groups[F1RACE_BENCH_BOX_GROUPS];
+static F1RACE_COLLISION_BOX bench_box_players[F1RACE_BENCH_BOX_GROUPS];
+
+static void Bench_Crashing(F1RACE_STATE *state) {
+	state->events |= F1RACE_EVENT_CRASH;
+	state->is_crashing = 1;
+	state->crashing_count_down = F1RACE_CRASHING_COUNT_DOWN;
+}
+
+/*
+ * F1Race_CollisionCheck() as it was before the collision kernels, the reference of the differential checks.
+ * Only the "is_empty" and "is_add_score" flags of a car are read from the traffic bitmasks instead.
+ */
+static void Bench_Collision_Reference(F1RACE_STATE *state) {
+	int16_t index;
+	int16_t minA_x, minA_y, maxA_x, maxA_y;
+	int16_t minB_x, minB_y, maxB_x, maxB_y;
+	F1RACE_TRAFFIC *car = &state->traffic;
+
+	minA_x = state->player_car.pos_x - 1;
+	maxA_x = minA_x + state->player_car.dx - 1;
+	minA_y = state->player_car.pos_y - 1;
+	maxA_y = minA_y + state->player_car.dy - 1;
+
+	for (index = 0; index < F1RACE_OPPOSITE_CAR_COUNT; index++) {
+		if (F1RACE_TRAFFIC_IS_ACTIVE(car, index)) {
+			minB_x = car->pos_x[index] - 1;
+			maxB_x = minB_x + car->dx[index] - 1;
+			minB_y = car->pos_y[index] - 1;
+			maxB_y = minB_y + car->dy[index] - 1;
+			if (((minA_x <= minB_x) && (minB_x <= maxA_x)) || ((minA_x <= maxB_x) && (maxB_x <= maxA_x))) {
+				if (((minA_y <= minB_y) && (minB_y <= maxA_y)) || ((minA_y <= maxB_y) && (maxB_y <= maxA_y))) {
+					Bench_Crashing(state);
+					return;
+				}
+			}
+
+			if ((minA_x >= minB_x) && (minA_x <= maxB_x) && (minA_y >= minB_y) && (minA_y <= maxB_y)) {
+				Bench_Crashing(state);
+				return;
+			}
+
+			if ((minA_x >= minB_x) && (minA_x <= maxB_x) && (maxA_y >= minB_y) && (maxA_y <= maxB_y)) {
+				Bench_Crashing(state);
+				return;
+			}
+
+			if ((maxA_x >= minB_x) && (maxA_x <= maxB_x) && (minA_y >= minB_y) && (minA_y <= maxB_y)) {
+				Bench_Crashing(state);
+				return;
+			}
+
+			if ((maxA_x >= minB_x) && (maxA_x <= maxB_x) && (maxA_y >= minB_y) && (maxA_y <= maxB_y)) {
+				Bench_Crashing(state);
+				return;
+			}
+
+			if ((maxA_y < minB_y) && ((car->scored[index >> 6] >> (index & 63)) & 1) == 0) {
+				state->events |= F1RACE_EVENT_PASS;
+				state->score++;
+				state->pass++;
+				car->scored[index >> 6] |= 1ull << (index & 63);
+
+				if (state->pass == 10)
+					state->level++; /* level 2 */
+				else if (state->pass == 20)
+					state->level++; /* level 3 */
+				else if (state->pass == 30)
+					state->level++; /* level 4 */
+				else if (state->pass == 40)
+					state->level++; /* level 5 */
+				else if (state->pass == 50)
+					state->level++; /* level 6 */
+				else if (state->pass == 60)
+					state->level++; /* level 7 */
+				else if (state->pass == 70)
+					state->level++; /* level 8 */
+				else if (state->pass == 100)
+					state->level++; /* level 9 */
+
+				state->fly_charger_count++;
+				if (state->fly_charger_count >= 6) {
+					if (state->fly_count < F1RACE_MAX_FLY_COUNT) {
+						state->fly_charger_count = 0;
+						state->fly_count++;
+					} else
+						state->fly_charger_count--;
+				}
+			}
+		}
+	}
+}
+
+/* One car of the reference above: the five crash conditions in their original form. */
+static uint32_t Bench_Collision_Reference_Hit(const F1RACE_COLLISION_BOX *a, const F1RACE_COLLISION_BOX *b) {
+	if (((a->min_x <= b->min_x) && (b->min_x <= a->max_x)) || ((a->min_x <= b->max_x) && (b->max_x <= a->max_x)))
+		if (((a->min_y <= b->min_y) && (b->min_y <= a->max_y)) || ((a->min_y <= b->max_y) && (b->max_y <= a->max_y)))
+			return 1;
+	if ((a->min_x >= b->min_x) && (a->min_x <= b->max_x) && (a->min_y >= b->min_y) && (a->min_y <= b->max_y))
+		return 1;
+	if ((a->min_x >= b->min_x) && (a->min_x <= b->max_x) && (a->max_y >= b->min_y) && (a->max_y <= b->max_y))
+		return 1;
+	if ((a->max_x >= b->min_x) && (a->max_x <= b->max_x) && (a->min_y >= b->min_y) && (a->min_y <= b->max_y))
+		return 1;
+	if ((a->max_x >= b->min_x) && (a->max_x <= b->max_x) && (a->max_y >= b->min_y) && (a->max_y <= b->max_y))
+		return 1;
+	return 0;
+}
+
+/* Boxes of car sizes anywhere on the road and above it. */
+static void Bench_Box_Create(F1RACE_COLLISION_BOX *box, uint32_t *random) {
+	box->min_x = F1RACE_ROAD_0_START_X - 1 + Bench_Random(random) % (F1RACE_ROAD_2_END_X - F1RACE_ROAD_0_START_X);
+	box->max_x = box->min_x + 11 + Bench_Random(random) % 12;
+	box->min_y = Bench_Random(random) % (F1RACE_DISPLAY_END_Y + 35) - 35;
+	box->max_y = box->min_y + 17 + Bench_Random(random) % 18;
+}
+
+/*
+ * Kernels only compare bounds, so their result depends on the order of the bounds alone. Intervals on six
+ * values give every order of two intervals including shared bounds, all pairs of them on both axes are tested.
+ */
+static uint32_t Bench_Collision_Exhaustive(F1RACE_COLLISION_KERNEL_FUNCTION function) {
+	F1RACE_COLLISION_BOX intervals[21], player, car;
+	F1RACE_COLLISION_BOXES cars;
+	uint32_t count = 0, mismatches = 0, lane = 0, expected = 0, a, b, c, d;
+	int16_t low, high;
+
+	for (low = 0; low < 6; low++)
+		for (high = low; high < 6; high++) {
+			intervals[count].min_x = intervals[count].min_y = low;
+			intervals[count].max_x = intervals[count].max_y = high;
+			count++;
+		}
+	for (a = 0; a < count; a++)
+		for (b = 0; b < count; b++) {
+			player.min_x = intervals[a].min_x;
+			player.max_x = intervals[a].max_x;
+			player.min_y = intervals[b].min_y;
+			player.max_y = intervals[b].max_y;
+			for (c = 0; c < count; c++)
+				for (d = 0; d < count; d++) {
+					car.min_x = cars.min_x[lane] = intervals[c].min_x;
+					car.max_x = cars.max_x[lane] = intervals[c].max_x;
+					car.min_y = cars.min_y[lane] = intervals[d].min_y;
+					car.max_y = cars.max_y[lane] = intervals[d].max_y;
+					expected |= Bench_Collision_Reference_Hit(&player, &car) << lane;
+					if (++lane < F1RACE_COLLISION_LANES && c * count + d + 1 < count * count)
+						continue;
+					if ((function(&cars, &player) & ((1u << lane) - 1)) != expected)
+						mismatches++;
+					lane = 0;
+					expected = 0;
+				}
+		}
+	return mismatches;
+}
+
+static void Bench_Box_Groups_Create(void) {
+	F1RACE_COLLISION_BOX box;
+	uint32_t random = options.seed, group, lane;
+	for (group = 0; group < F1RACE_BENCH_BOX_GROUPS; group++) {
+		Bench_Box_Create(&bench_box_players[group], &random);
+		for (lane = 0; lane < F1RACE_COLLISION_LANES; lane++) {
+			Bench_Box_Create(&box, &random);
+			bench_box_groups[group].min_x[lane] = box.min_x;
+			bench_box_groups[group].max_x[lane] = box.max_x;
+			bench_box_groups[group].min_y[lane] = box.min_y;
+			bench_box_groups[group].max_y[lane] = box.max_y;
+		}
+	}
+}
+
+/* Hit masks of every kernel against the original conditions car by car, then the time of the kernel alone. */
+static void Bench_Collision(void) {
+	F1RACE_COLLISION_KERNEL_FUNCTION function;
+	F1RACE_COLLISION_BOX car;
+	uint32_t kernel, group, lane, frame, expected, mismatches, hits;
+	double start, elapsed;
+
+	Bench_Box_Groups_Create();
+	for (kernel = 0; kernel < F1RACE_COLLISION_KERNEL_COUNT; kernel++) {
+		if ((function = F1Race_Collision_Kernel(kernel)) == NULL) {
+			printf("collision/%-12s not available\n", F1Race_Collision_Kernel_Name(kernel));
+			continue;
+		}
+		mismatches = Bench_Collision_Exhaustive(function);
+		for (group = 0; group < F1RACE_BENCH_BOX_GROUPS; group++) {
+			expected = 0;
+			for (lane = 0; lane < F1RACE_COLLISION_LANES; lane++) {
+				car.min_x = bench_box_groups[group].min_x[lane];
+				car.max_x = bench_box_groups[group].max_x[lane];
+				car.min_y = bench_box_groups[group].min_y[lane];
+				car.max_y = bench_box_groups[group].max_y[lane];
+				expected |= Bench_Collision_Reference_Hit(&bench_box_players[group], &car) << lane;
+			}
+			if (function(&bench_box_groups[group], &bench_box_players[group]) != expected)
+				mismatches++;
+		}
+
+		hits = 0;
+		start = Bench_Time();
+		for (frame = 0; frame < options.frames; frame++)
+			hits += function(&bench_box_groups[frame & (F1RACE_BENCH_BOX_GROUPS - 1)],
+				&bench_box_players[frame & (F1RACE_BENCH_BOX_GROUPS - 1)]) != 0;
+		elapsed = Bench_Time() - start;
+		printf("collision/%-12s %10.1f Mcars/sec %10.2f ns/call %s (%u of %u calls hit)\n",
+			F1Race_Collision_Kernel_Name(kernel), options.frames * (double) F1RACE_COLLISION_LANES / elapsed / 1e6,
+			elapsed * 1e9 / options.frames, mismatches ? "MISMATCH" : "ok", hits, options.frames);
+	}
+}
+
+/* Whole F1Race_CollisionCheck() against the reference on the logic layouts: crashes, scores and levels. */
+static void Bench_Collision_Core(void) {
+	F1RACE_STATE state, reference;
+	uint32_t index, mismatches = 0, crashes = 0;
+
+	Bench_Logic_Create();
+	for (index = 0; index < F1RACE_BENCH_LAYOUTS; index++) {
+		state = bench_layouts[index];
+		reference = bench_layouts[index];
+		F1Race_CollisionCheck(&state);
+		Bench_Collision_Reference(&reference);
+		if (memcmp(&state, &reference, sizeof(F1RACE_STATE)) != 0)
+			mismatches++;
+		crashes += reference.is_crashing;
+	}
+	printf("collision/%-12s %u layouts, %u crashes %s\n", "core", F1RACE_BENCH_LAYOUTS, crashes,
+		mismatches ? "MISMATCH" : "ok");
+}
+
+/* Clear rows of a lane counted car by car, the reference of the bitboard queries. */
+static int16_t Bench_Lane_Reference(const F1RACE_STATE *state, int16_t lane, int16_t y, int16_t rows) {
+	const F1RACE_TRAFFIC *traffic = &state->traffic;
+	int16_t row, car, occupied = 0;
+	for (row = y; row < y + rows; row++) {
+		if (row < F1RACE_BITBOARD_TOP_Y || row >= F1RACE_BITBOARD_TOP_Y + F1RACE_BITBOARD_ROWS)
+			continue;
+		for (car = 0; car < F1RACE_CLASSIC_CARS; car++)
+			if (F1RACE_TRAFFIC_IS_ACTIVE(traffic, car) && traffic->road_id[car] == lane &&
+				traffic->pos_y[car] <= row && row < traffic->pos_y[car] + traffic->dy[car]) {
+				occupied++;
+				break;
+			}
+	}
+	return occupied;
+}
+
+/*
+ * Lane queries against the cars on the logic layouts and on every tick of a game, which rebuilds the boards
+ * on the first query, then the time of a gap and a clear query per lane.
+ */
+static void Bench_Bitboard(void) {
+	static F1RACE_STATE game;
+	F1RACE_STATE *state;
+	uint32_t random = options.seed, index, frame, mismatches = 0, clear = 0;
+	int16_t lane, y, rows, gap, expected;
+	double start, elapsed;
+
+	Bench_Logic_Create();
+	F1Race_Seed(&game, options.seed);
+	F1Race_Init(&game);
+	for (index = 0; index < F1RACE_BENCH_LAYOUTS * 2; index++) {
+		state = (index < F1RACE_BENCH_LAYOUTS) ? &bench_layouts[index] : &game;
+		if (state == &game)
+			F1Race_Step(&game, bench_inputs[index & (F1RACE_BENCH_INPUTS - 1)]);
+		for (lane = 0; lane < F1RACE_CLASSIC_LANES; lane++) {
+			y = F1RACE_BITBOARD_TOP_Y - 8 + Bench_Random(&random) % (F1RACE_BITBOARD_ROWS + 16);
+			rows = Bench_Random(&random) % 160;
+			expected = Bench_Lane_Reference(state, lane, y, rows);
+			if (F1Race_Lane_Occupied(state, lane, y, rows) != expected ||
+				F1Race_Lane_Is_Clear(state, lane, y, rows) != (expected == 0))
+				mismatches++;
+			for (gap = 0; gap < state->player_car.pos_y - F1RACE_BITBOARD_TOP_Y; gap++)
+				if (Bench_Lane_Reference(state, lane, state->player_car.pos_y - gap - 1, 1) != 0)
+					break;
+			if (F1Race_Lane_Gap(state, lane) != gap)
+				mismatches++;
+		}
+	}
+
+	start = Bench_Time();
+	for (frame = 0; frame < options.frames; frame++) {
+		state = &bench_layouts[frame & (F1RACE_BENCH_LAYOUTS - 1)];
+		lane = frame % F1RACE_CLASSIC_LANES;
+		clear += F1Race_Lane_Is_Clear(state, lane, state->player_car.pos_y - F1Race_Lane_Gap(state, lane) - 8, 8);
+	}
+	elapsed = Bench_Time() - start;
+	printf("bitboard/%-13s %10.1f Mqueries/sec %10.2f ns/query %s (%u of %u clear)\n", "queries",
+		options.frames * 2.0 / elapsed / 1e6, elapsed * 1e9 / options.frames / 2.0, mismatches ? "MISMATCH" : "ok",
+		clear, options.frames);
+}
+
+/* Uneven weights with empty and dominant car types, checked along with the classic rules. */
+static const char bench_rules[] =
+	"levels 4\n"
+	"level 2 5 1 0 0 0 0 0 0 1 # one car type only\n"
+	"level 3 15 2 65000 1 1 1 1 1 1\n"
+	"level 4 16 9 9 8 7 6 5 4 3\n";
+
+/* Chances of every car type over all columns and coins of a sampler, which must be its weights times the columns. */
+static uint32_t Bench_Sampler_Check(const F1RACE_SAMPLER *sampler, const uint16_t *weights) {
+	uint32_t counts[F1RACE_OPPOSITE_CAR_TYPE_COUNT] = { 0 };
+	uint32_t column, coin, mismatches = 0;
+	for (column = 0; column < F1RACE_OPPOSITE_CAR_TYPE_COUNT; column++)
+		for (coin = 0; coin < sampler->total; coin++)
+			counts[(coin < sampler->keep[column]) ? column : sampler->alias[column]]++;
+	for (column = 0; column < F1RACE_OPPOSITE_CAR_TYPE_COUNT; column++)
+		if (counts[column] != (uint32_t) weights[column] * F1RACE_OPPOSITE_CAR_TYPE_COUNT)
+			mismatches++;
+	return mismatches;
+}
+
+static uint32_t Bench_Rules_Check(const F1RACE_RULESET *ruleset, const F1RACE_RULES *rules) {
+	uint32_t mismatches = 0;
+	int16_t level;
+	for (level = 1; level <= F1RACE_MAX_LEVEL; level++) {
+		mismatches += Bench_Sampler_Check(&ruleset->samplers[level],
+			rules->weights[(level < rules->levels) ? level - 1 : rules->levels - 1]);
+		if (ruleset->next_pass[level] != ((level < rules->levels) ? rules->level_passes[level] : -1))
+			mismatches++;
+	}
+	return mismatches;
+}
+
+/* Spawn samplers of the classic and test rules checked chance by chance, then the time of a car type draw. */
+static void Bench_Samplers(void) {
+	static F1RACE_STATE state;
+	F1RACE_RULES rules;
+	F1RACE_RULESET ruleset;
+	uint32_t frame, sum = 0, mismatches = 0;
+	const F1RACE_SAMPLER *samplers;
+	double start, elapsed;
+
+	F1Race_Rules_Classic(&rules);
+	if (!F1Race_Rules_Compile(&ruleset, &rules) || memcmp(&ruleset, F1Race_Ruleset_Classic(), sizeof(ruleset)) != 0)
+		mismatches++;
+	mismatches += Bench_Rules_Check(F1Race_Ruleset_Classic(), &rules);
+	if (F1Race_Rules_Parse(&rules, bench_rules, sizeof(bench_rules) - 1) != 0 || !F1Race_Rules_Compile(&ruleset, &rules))
+		mismatches++;
+	else
+		mismatches += Bench_Rules_Check(&ruleset, &rules);
+
+	F1Race_Seed(&state, options.seed);
+	samplers = F1Race_Ruleset_Classic()->samplers;
+	start = Bench_Time();
+	for (frame = 0; frame < options.frames; frame++)
+		sum += F1Race_Sample(&state, &samplers[1 + frame % F1RACE_MAX_LEVEL]);
+	elapsed = Bench_Time() - start;
+	printf("spawn/%-16s %10.1f Mdraws/sec %10.2f ns/draw %s (type sum %u)\n", "samplers",
+		options.frames / elapsed / 1e6, elapsed * 1e9 / options.frames, mismatches ? "MISMATCH" : "ok", sum);
+}
+
+static F1RACE_STATE bench_rewind_states[F1RACE_BENCH_REWIND];
+
+/*
+ * Games rewound from a full ring by a random number of ticks and played again with the same inputs must
+ * end in the same state, then the time of a per-tick push, alone and followed by a restore.
+ */
+static void Bench_Rewind(void) {
+	static F1RACE_STATE state, replayed;
+	F1RACE_REWIND rewind;
+	uint8_t inputs[F1RACE_BENCH_REWIND];
+	uint32_t random = options.seed, round, tick, back, frame, mismatches = 0;
+	double start, push, restore;
+
+	F1Race_Rewind_Init(&rewind, bench_rewind_states, F1RACE_BENCH_REWIND);
+	F1Race_Seed(&state, options.seed);
+	F1Race_Configure(&state, &options.traffic);
+	F1Race_Init(&state);
+	for (round = 0; round < F1RACE_BENCH_REWIND_ROUNDS; round++) {
+		for (tick = 0; tick < F1RACE_BENCH_REWIND; tick++) {
+			inputs[tick] = Bench_Random(&random) & (F1RACE_INPUT_DIRECTIONS | F1RACE_INPUT_FLY);
+			F1Race_Rewind_Push(&rewind, &state);
+			F1Race_Step(&state, inputs[tick]);
+		}
+		back = Bench_Random(&random) % F1RACE_BENCH_REWIND;
+		if (!F1Race_Rewind_Back(&rewind, back, &replayed) || rewind.count != F1RACE_BENCH_REWIND - back - 1)
+			mismatches++;
+		for (tick = F1RACE_BENCH_REWIND - back - 1; tick < F1RACE_BENCH_REWIND; tick++)
+			F1Race_Step(&replayed, inputs[tick]);
+		if (memcmp(&replayed, &state, sizeof(F1RACE_STATE)) != 0)
+			mismatches++;
+	}
+
+	Bench_Logic_Create();
+	start = Bench_Time();
+	for (frame = 0; frame < options.frames; frame++)
+		F1Race_Rewind_Push(&rewind, &bench_layouts[frame & (F1RACE_BENCH_LAYOUTS - 1)]);
+	push = Bench_Time() - start;
+	start = Bench_Time();
+	for (frame = 0; frame < options.frames; frame++) {
+		F1Race_Rewind_Push(&rewind, &bench_layouts[frame & (F1RACE_BENCH_LAYOUTS - 1)]);
+		F1Race_Rewind_Back(&rewind, 0, &replayed);
+	}
+	restore = Bench_Time() - start;
+	printf("snapshot/%-13s %10.2f ns/push %10.2f ns/push+restore %s (%u bytes per state)\n", "rewind",
+		push * 1e9 / options.frames, restore * 1e9 / options.frames, mismatches ? "MISMATCH" : "ok",
+		(unsigned) sizeof(F1RACE_STATE));
+}
+
+static const BENCH_CASE bench_cases[] = {
+	{ "blit", Bench_Blit },
+	{ "logic/collision", Bench_Logic_Collision },
+	{ "logic/new_car", Bench_Logic_New_Car },
+	{ "logic/framemove", Bench_Logic_Framemove },
+	{ "logic/tick", Bench_Logic_Tick },
+	{ "collision/kernels", Bench_Collision },
+	{ "collision/core", Bench_Collision_Core },
+	{ "bitboard/queries", Bench_Bitboard },
+	{ "spawn/samplers", Bench_Samplers },
+	{ "snapshot/rewind", Bench_Rewind }
+};
+
+static void Bench_Usage(const char *program) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -f, --frames N       iterations of every benchmark (default: %d)\n"
+		"  -r, --repetitions N  timed runs of every logic benchmark, up to %d (default: %d)\n"
+		"  -w, --warmup N       untimed runs before them (default: %d)\n"
+		"  -s, --seed N         seed of the generated workloads (default: 1)\n"
+		"  -n, --filter NAME    run only benchmarks which names contain NAME\n"
+		"  -T, --traffic L,C[,D[,S]]  stress traffic of logic/tick: lanes, cars up to %d, depth, spawns per tick,\n"
+		"                       more cars need a \"make build-bench-stress\" or \"TRAFFIC=\" build\n",
+		program, F1RACE_BENCH_DEFAULT_FRAMES, F1RACE_BENCH_MAX_REPETITIONS, F1RACE_BENCH_DEFAULT_REPETITIONS,
+		F1RACE_BENCH_DEFAULT_WARMUP, F1RACE_OPPOSITE_CAR_COUNT);
+}
+
+static int Bench_Parse_Options(int argc, char *argv[]) {
+	int index;
+	const char *value;
+	F1RACE_TRAFFIC_ERROR error;
+
+	options.frames = F1RACE_BENCH_DEFAULT_FRAMES;
+	options.repetitions = F1RACE_BENCH_DEFAULT_REPETITIONS;
+	options.warmup = F1RACE_BENCH_DEFAULT_WARMUP;
+	options.seed = 1;
+	options.filter = NULL;
+	F1Race_Traffic_Classic(&options.traffic);
+
+	for (index = 1; index < argc; index++) {
+		if (!strcmp(argv[index], "-h") || !strcmp(argv[index], "--help"))
+			return 0;
+		if (index + 1 >= argc) {
+			fprintf(stderr, "Missing value for option: %s.\n", argv[index]);
+			return 0;
+		}
+		value = argv[++index];
+		if (!strcmp(argv[index - 1], "-f") || !strcmp(argv[index - 1], "--frames"))
+			options.frames = strtoul(value, NULL, 10);
+		else if (!strcmp(argv[index - 1], "-r") || !strcmp(argv[index - 1], "--repetitions"))
+			options.repetitions = strtoul(value, NULL, 10);
+		else if (!strcmp(argv[index - 1], "-w") || !strcmp(argv[index - 1], "--warmup"))
+			options.warmup = strtoul(value, NULL, 10);
+		else if (!strcmp(argv[index - 1], "-s") || !strcmp(argv[index - 1], "--seed"))
+			options.seed = strtoul(value, NULL, 10);
+		else if (!strcmp(argv[index - 1], "-n") || !strcmp(argv[index - 1], "--filter"))
+			options.filter = value;
+		else if (!strcmp(argv[index - 1], "-T") || !strcmp(argv[index - 1], "--traffic")) {
+			error = F1Race_Traffic_Parse(&options.traffic, value);
+			if (error != F1RACE_TRAFFIC_OK) {
+				fprintf(stderr, "Wrong traffic: %s, %s, this build takes 1-%d lanes, 1-%d cars, depth 0-%d and "
+					"1-%d spawns.\n", value, F1Race_Traffic_Error(error), F1RACE_MAX_LANES, F1RACE_OPPOSITE_CAR_COUNT,
+					F1RACE_MAX_TRAFFIC_DEPTH, F1RACE_MAX_LANES);
+				if (error == F1RACE_TRAFFIC_CARS)
+					fprintf(stderr, "Build with TRAFFIC=-DF1RACE_OPPOSITE_CAR_COUNT=N for more cars.\n");
+				return 0;
+			}
+		} else {
+			fprintf(stderr, "Unknown option: %s.\n", argv[index - 1]);
+			return 0;
+		}
+	}
+
+	if (options.frames < 1)
+		options.frames = 1;
+	if (options.repetitions < 1)
+		options.repetitions = 1;
+	if (options.repetitions > F1RACE_BENCH_MAX_REPETITIONS)
+		options.repetitions = F1RACE_BENCH_MAX_REPETITIONS;
+	if (options.seed == 0)
+		options.seed = 1;
+	return 1;
+}
+
+int main(int argc, char *argv[]) {
+	uint32_t index;
+
+	if (!Bench_Parse_Options(argc, argv)) {
+		Bench_Usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	for (index = 0; index < sizeof(bench_cases) / sizeof(bench_cases[0]); index++)
+		if (options.filter == NULL || strstr(bench_cases[index].name, options.filter))
+			bench_cases[index].run();
+
+	return EXIT_SUCCESS;
+}
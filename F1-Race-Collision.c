@@ -0,0 +1,165 @@
+/*
+ * About:
+ *   Collision kernels of the "F1 Race" game: tests the player car against a group of opposite cars at once.
+ *
+ * License:
+ *   MIT
+ */
+
+#include "F1-Race-Collision.h"
+
+#include <stddef.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define F1RACE_COLLISION_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define F1RACE_COLLISION_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(__wasm_simd128__)
+#define F1RACE_COLLISION_WASM_SIMD
+#include <wasm_simd128.h>
+#endif
+
+/*
+ * Every kernel computes the same expression: the car edges inside the player box on both axes, or the
+ * player corners inside the car box on both axes. Comparisons are evaluated as values, no early exits.
+ */
+static uint32_t F1Race_Collision_Hits_Scalar(const F1RACE_COLLISION_BOXES *cars, const F1RACE_COLLISION_BOX *player) {
+	uint32_t hits = 0, index, edge_x, edge_y, corner_x, corner_y;
+	for (index = 0; index < F1RACE_COLLISION_LANES; index++) {
+		edge_x = ((player->min_x <= cars->min_x[index]) & (cars->min_x[index] <= player->max_x)) |
+			((player->min_x <= cars->max_x[index]) & (cars->max_x[index] <= player->max_x));
+		edge_y = ((player->min_y <= cars->min_y[index]) & (cars->min_y[index] <= player->max_y)) |
+			((player->min_y <= cars->max_y[index]) & (cars->max_y[index] <= player->max_y));
+		corner_x = ((cars->min_x[index] <= player->min_x) & (player->min_x <= cars->max_x[index])) |
+			((cars->min_x[index] <= player->max_x) & (player->max_x <= cars->max_x[index]));
+		corner_y = ((cars->min_y[index] <= player->min_y) & (player->min_y <= cars->max_y[index])) |
+			((cars->min_y[index] <= player->max_y) & (player->max_y <= cars->max_y[index]));
+		hits |= ((edge_x & edge_y) | (corner_x & corner_y)) << index;
+	}
+	return hits;
+}
+
+#if defined(F1RACE_COLLISION_SSE2)
+#define F1RACE_COLLISION_OUTSIDE_SSE2(v, low, high)    _mm_or_si128(_mm_cmpgt_epi16(low, v), _mm_cmpgt_epi16(v, high))
+
+static uint32_t F1Race_Collision_Hits_SSE2(const F1RACE_COLLISION_BOXES *cars, const F1RACE_COLLISION_BOX *player) {
+	const __m128i a_min_x = _mm_set1_epi16(player->min_x);
+	const __m128i a_max_x = _mm_set1_epi16(player->max_x);
+	const __m128i a_min_y = _mm_set1_epi16(player->min_y);
+	const __m128i a_max_y = _mm_set1_epi16(player->max_y);
+	const __m128i b_min_x = _mm_loadu_si128((const __m128i *) cars->min_x);
+	const __m128i b_max_x = _mm_loadu_si128((const __m128i *) cars->max_x);
+	const __m128i b_min_y = _mm_loadu_si128((const __m128i *) cars->min_y);
+	const __m128i b_max_y = _mm_loadu_si128((const __m128i *) cars->max_y);
+	__m128i no_edge_x = _mm_and_si128(F1RACE_COLLISION_OUTSIDE_SSE2(b_min_x, a_min_x, a_max_x),
+		F1RACE_COLLISION_OUTSIDE_SSE2(b_max_x, a_min_x, a_max_x));
+	__m128i no_edge_y = _mm_and_si128(F1RACE_COLLISION_OUTSIDE_SSE2(b_min_y, a_min_y, a_max_y),
+		F1RACE_COLLISION_OUTSIDE_SSE2(b_max_y, a_min_y, a_max_y));
+	__m128i no_corner_x = _mm_and_si128(F1RACE_COLLISION_OUTSIDE_SSE2(a_min_x, b_min_x, b_max_x),
+		F1RACE_COLLISION_OUTSIDE_SSE2(a_max_x, b_min_x, b_max_x));
+	__m128i no_corner_y = _mm_and_si128(F1RACE_COLLISION_OUTSIDE_SSE2(a_min_y, b_min_y, b_max_y),
+		F1RACE_COLLISION_OUTSIDE_SSE2(a_max_y, b_min_y, b_max_y));
+	__m128i miss = _mm_and_si128(_mm_or_si128(no_edge_x, no_edge_y), _mm_or_si128(no_corner_x, no_corner_y));
+	return ~(uint32_t) _mm_movemask_epi8(_mm_packs_epi16(miss, _mm_setzero_si128())) & 0xFF;
+}
+#endif
+
+#if defined(F1RACE_COLLISION_NEON)
+#define F1RACE_COLLISION_OUTSIDE_NEON(v, low, high)    vorrq_u16(vcgtq_s16(low, v), vcgtq_s16(v, high))
+
+static uint32_t F1Race_Collision_Hits_NEON(const F1RACE_COLLISION_BOXES *cars, const F1RACE_COLLISION_BOX *player) {
+	static const uint16_t lanes[F1RACE_COLLISION_LANES] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+	const int16x8_t a_min_x = vdupq_n_s16(player->min_x);
+	const int16x8_t a_max_x = vdupq_n_s16(player->max_x);
+	const int16x8_t a_min_y = vdupq_n_s16(player->min_y);
+	const int16x8_t a_max_y = vdupq_n_s16(player->max_y);
+	const int16x8_t b_min_x = vld1q_s16(cars->min_x);
+	const int16x8_t b_max_x = vld1q_s16(cars->max_x);
+	const int16x8_t b_min_y = vld1q_s16(cars->min_y);
+	const int16x8_t b_max_y = vld1q_s16(cars->max_y);
+	uint16x8_t no_edge_x = vandq_u16(F1RACE_COLLISION_OUTSIDE_NEON(b_min_x, a_min_x, a_max_x),
+		F1RACE_COLLISION_OUTSIDE_NEON(b_max_x, a_min_x, a_max_x));
+	uint16x8_t no_edge_y = vandq_u16(F1RACE_COLLISION_OUTSIDE_NEON(b_min_y, a_min_y, a_max_y),
+		F1RACE_COLLISION_OUTSIDE_NEON(b_max_y, a_min_y, a_max_y));
+	uint16x8_t no_corner_x = vandq_u16(F1RACE_COLLISION_OUTSIDE_NEON(a_min_x, b_min_x, b_max_x),
+		F1RACE_COLLISION_OUTSIDE_NEON(a_max_x, b_min_x, b_max_x));
+	uint16x8_t no_corner_y = vandq_u16(F1RACE_COLLISION_OUTSIDE_NEON(a_min_y, b_min_y, b_max_y),
+		F1RACE_COLLISION_OUTSIDE_NEON(a_max_y, b_min_y, b_max_y));
+	uint16x8_t miss = vandq_u16(vorrq_u16(no_edge_x, no_edge_y), vorrq_u16(no_corner_x, no_corner_y));
+	return vaddvq_u16(vbicq_u16(vld1q_u16(lanes), miss));
+}
+#endif
+
+#if defined(F1RACE_COLLISION_WASM_SIMD)
+#define F1RACE_COLLISION_OUTSIDE_WASM(v, low, high)    wasm_v128_or(wasm_i16x8_gt(low, v), wasm_i16x8_gt(v, high))
+
+static uint32_t F1Race_Collision_Hits_Wasm_SIMD(const F1RACE_COLLISION_BOXES *cars,
+		const F1RACE_COLLISION_BOX *player) {
+	const v128_t a_min_x = wasm_i16x8_splat(player->min_x);
+	const v128_t a_max_x = wasm_i16x8_splat(player->max_x);
+	const v128_t a_min_y = wasm_i16x8_splat(player->min_y);
+	const v128_t a_max_y = wasm_i16x8_splat(player->max_y);
+	const v128_t b_min_x = wasm_v128_load(cars->min_x);
+	const v128_t b_max_x = wasm_v128_load(cars->max_x);
+	const v128_t b_min_y = wasm_v128_load(cars->min_y);
+	const v128_t b_max_y = wasm_v128_load(cars->max_y);
+	v128_t no_edge_x = wasm_v128_and(F1RACE_COLLISION_OUTSIDE_WASM(b_min_x, a_min_x, a_max_x),
+		F1RACE_COLLISION_OUTSIDE_WASM(b_max_x, a_min_x, a_max_x));
+	v128_t no_edge_y = wasm_v128_and(F1RACE_COLLISION_OUTSIDE_WASM(b_min_y, a_min_y, a_max_y),
+		F1RACE_COLLISION_OUTSIDE_WASM(b_max_y, a_min_y, a_max_y));
+	v128_t no_corner_x = wasm_v128_and(F1RACE_COLLISION_OUTSIDE_WASM(a_min_x, b_min_x, b_max_x),
+		F1RACE_COLLISION_OUTSIDE_WASM(a_max_x, b_min_x, b_max_x));
+	v128_t no_corner_y = wasm_v128_and(F1RACE_COLLISION_OUTSIDE_WASM(a_min_y, b_min_y, b_max_y),
+		F1RACE_COLLISION_OUTSIDE_WASM(a_max_y, b_min_y, b_max_y));
+	v128_t miss = wasm_v128_and(wasm_v128_or(no_edge_x, no_edge_y), wasm_v128_or(no_corner_x, no_corner_y));
+	return wasm_i16x8_bitmask(wasm_v128_not(miss));
+}
+#endif
+
+F1RACE_COLLISION_KERNEL_FUNCTION F1Race_Collision_Kernel(F1RACE_COLLISION_KERNEL kernel) {
+	switch (kernel) {
+		case F1RACE_COLLISION_KERNEL_SCALAR:
+			return F1Race_Collision_Hits_Scalar;
+#if defined(F1RACE_COLLISION_SSE2)
+		case F1RACE_COLLISION_KERNEL_SSE2:
+			return F1Race_Collision_Hits_SSE2;
+#endif
+#if defined(F1RACE_COLLISION_NEON)
+		case F1RACE_COLLISION_KERNEL_NEON:
+			return F1Race_Collision_Hits_NEON;
+#endif
+#if defined(F1RACE_COLLISION_WASM_SIMD)
+		case F1RACE_COLLISION_KERNEL_WASM_SIMD:
+			return F1Race_Collision_Hits_Wasm_SIMD;
+#endif
+		default:
+			return NULL;
+	}
+}
+
+int F1Race_Collision_Kernel_Available(F1RACE_COLLISION_KERNEL kernel) {
+	return F1Race_Collision_Kernel(kernel) != NULL;
+}
+
+const char *F1Race_Collision_Kernel_Name(F1RACE_COLLISION_KERNEL kernel) {
+	static const char *names[F1RACE_COLLISION_KERNEL_COUNT] = { "scalar", "sse2", "neon", "wasm-simd" };
+	return (kernel < F1RACE_COLLISION_KERNEL_COUNT) ? names[kernel] : "unknown";
+}
+
+uint32_t F1Race_Collision_Hits(const F1RACE_COLLISION_BOXES *cars, const F1RACE_COLLISION_BOX *player) {
+#if defined(F1RACE_COLLISION_SSE2)
+	return F1Race_Collision_Hits_SSE2(cars, player);
+#elif defined(F1RACE_COLLISION_NEON)
+	return F1Race_Collision_Hits_NEON(cars, player);
+#elif defined(F1RACE_COLLISION_WASM_SIMD)
+	return F1Race_Collision_Hits_Wasm_SIMD(cars, player);
+#else
+	return F1Race_Collision_Hits_Scalar(cars, player);
+#endif
+}
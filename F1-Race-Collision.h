@@ -0,0 +1,55 @@
+/*
+ * About:
+ *   Collision kernels of the "F1 Race" game: tests the player car against a group of opposite cars at once.
+ *
+ * License:
+ *   MIT
+ */
+
+#ifndef F1_RACE_COLLISION_H
+#define F1_RACE_COLLISION_H
+
+#include <stdint.h>
+
+#define F1RACE_COLLISION_LANES                         (8)
+
+typedef enum F1RACE_COLLISION_KERNELS {
+	F1RACE_COLLISION_KERNEL_SCALAR,
+	F1RACE_COLLISION_KERNEL_SSE2,
+	F1RACE_COLLISION_KERNEL_NEON,
+	F1RACE_COLLISION_KERNEL_WASM_SIMD,
+	F1RACE_COLLISION_KERNEL_COUNT
+} F1RACE_COLLISION_KERNEL;
+
+/* Inclusive bounds, the same Sint16 values F1Race_CollisionCheck() always compared. */
+typedef struct {
+	int16_t min_x;
+	int16_t max_x;
+	int16_t min_y;
+	int16_t max_y;
+} F1RACE_COLLISION_BOX;
+
+/* Boxes of up to F1RACE_COLLISION_LANES cars, one array per bound so a kernel loads each bound at once. */
+typedef struct {
+	int16_t min_x[F1RACE_COLLISION_LANES];
+	int16_t max_x[F1RACE_COLLISION_LANES];
+	int16_t min_y[F1RACE_COLLISION_LANES];
+	int16_t max_y[F1RACE_COLLISION_LANES];
+} F1RACE_COLLISION_BOXES;
+
+/*
+ * Returns a mask with bit N set if the player crashes into car N. It is not a plain overlap test: the game
+ * crashes when an edge of the car lies inside the player box on both axes, or a corner of the player box
+ * lies inside the car box, so a narrow car crossing a long one does not crash. Unused lanes must be masked.
+ */
+typedef uint32_t (*F1RACE_COLLISION_KERNEL_FUNCTION)(const F1RACE_COLLISION_BOXES *cars,
+	const F1RACE_COLLISION_BOX *player);
+
+int F1Race_Collision_Kernel_Available(F1RACE_COLLISION_KERNEL kernel);
+const char *F1Race_Collision_Kernel_Name(F1RACE_COLLISION_KERNEL kernel);
+F1RACE_COLLISION_KERNEL_FUNCTION F1Race_Collision_Kernel(F1RACE_COLLISION_KERNEL kernel);
+
+/* The widest kernel of the build, called directly without dispatch. */
+uint32_t F1Race_Collision_Hits(const F1RACE_COLLISION_BOXES *cars, const F1RACE_COLLISION_BOX *player);
+
+#endif /* F1_RACE_COLLISION_H */
@@ -0,0 +1,1146 @@
+/*
+ * About:
+ *   Headless and reentrant core of the "F1 Race" game: state, rules and logic without SDL.
+ *
+ * License:
+ *   MIT
+ */
+
+#include "F1-Race-Core.h"
+#include "F1-Race-Collision.h"
+#include "F1-Race-Trace.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if F1RACE_OPPOSITE_CAR_COUNT < F1RACE_CLASSIC_CARS || F1RACE_OPPOSITE_CAR_COUNT < F1RACE_COLLISION_LANES || \
+	F1RACE_OPPOSITE_CAR_COUNT > INT16_MAX
+#error "F1RACE_OPPOSITE_CAR_COUNT must fit the classic traffic and int16_t car indices."
+#endif
+
+#define F1RACE_TRAFFIC_BIT(index)                      (1ull << ((index) & 63))
+
+/*
+ * Traffic of up to one collision kernel call of cars is cheaper to scan through the bitmasks than to keep
+ * sorted, the lane lists are only kept for larger traffic. Both ways play the same game.
+ */
+#ifndef F1RACE_TRAFFIC_SCAN_CARS
+#define F1RACE_TRAFFIC_SCAN_CARS                       (F1RACE_COLLISION_LANES)
+#endif
+#define F1RACE_TRAFFIC_SCANNED(config)                 ((config)->capacity <= F1RACE_TRAFFIC_SCAN_CARS)
+
+#if F1RACE_TRAFFIC_SCAN_CARS > F1RACE_COLLISION_LANES
+#error "Scanned traffic is tested in one collision kernel call."
+#endif
+
+/* New cars keep one and a half player cars of distance from the top of the screen. */
+#define F1RACE_SPAWN_SPACE                             (F1RACE_PLAYER_CAR_IMAGE_SIZE_Y * 3 / 2)
+#define F1RACE_SPAWN_ROWS                              (F1RACE_SPAWN_SPACE - 1 - F1RACE_BITBOARD_TOP_Y) /* Last board row. */
+
+/* SplitMix64, expands a 64-bit seed into the xoshiro128** state. */
+static uint64_t F1Race_SplitMix64(uint64_t *x) {
+	uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+void F1Race_Seed(F1RACE_STATE *state, uint64_t seed) {
+	uint64_t x = seed;
+	uint64_t z;
+	state->seed = seed;
+	F1Race_Traffic_Classic(&state->traffic_config);
+	state->ruleset = F1Race_Ruleset_Classic();
+	z = F1Race_SplitMix64(&x);
+	state->random[0] = (uint32_t) z;
+	state->random[1] = (uint32_t) (z >> 32);
+	z = F1Race_SplitMix64(&x);
+	state->random[2] = (uint32_t) z;
+	state->random[3] = (uint32_t) (z >> 32);
+}
+
+static uint32_t F1Race_Rotl(uint32_t x, int k) {
+	return (x << k) | (x >> (32 - k));
+}
+
+/* xoshiro128**, integer-only, so native and Emscripten builds produce the same traffic for the same seed. */
+uint32_t F1Race_Random(F1RACE_STATE *state) {
+	uint32_t *s = state->random;
+	uint32_t result = F1Race_Rotl(s[1] * 5, 7) * 9;
+	uint32_t t = s[1] << 9;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = F1Race_Rotl(s[3], 11);
+	return result;
+}
+
+uint32_t F1Race_Random_Below(F1RACE_STATE *state, uint32_t bound) {
+	return (uint32_t) (((uint64_t) F1Race_Random(state) * bound) >> 32);
+}
+
+static int16_t F1Race_Ctz64(uint64_t value) {
+#if defined(__GNUC__)
+	return (int16_t) __builtin_ctzll(value);
+#else
+	int16_t count = 0;
+	while ((value & 1) == 0) {
+		value >>= 1;
+		count++;
+	}
+	return count;
+#endif
+}
+
+/* Slots of a bitmask word that may hold cars, the last word may be partly used. */
+static uint64_t F1Race_Traffic_Slots(int16_t word, int16_t capacity) {
+	int16_t rest = capacity - word * 64;
+	return (rest >= 64) ? ~0ull : F1RACE_TRAFFIC_BIT(rest) - 1;
+}
+
+/* Lowest free slot, the same one the first-fit scan over "is_empty" flags used to find. */
+static int16_t F1Race_Traffic_Free(const F1RACE_TRAFFIC *traffic, int16_t capacity) {
+	int16_t word;
+	uint64_t free;
+	for (word = 0; word * 64 < capacity; word++) {
+		free = ~traffic->active[word] & F1Race_Traffic_Slots(word, capacity);
+		if (free != 0)
+			return word * 64 + F1Race_Ctz64(free);
+	}
+	return -1;
+}
+
+int16_t F1Race_Traffic_Next(const F1RACE_TRAFFIC *traffic, int16_t index) {
+	int16_t word = index >> 6;
+	uint64_t bits;
+	if (index >= F1RACE_OPPOSITE_CAR_COUNT)
+		return -1;
+	bits = traffic->active[word] & (~0ull << (index & 63));
+	while (bits == 0) {
+		if (++word >= F1RACE_TRAFFIC_WORDS)
+			return -1;
+		bits = traffic->active[word];
+	}
+	return word * 64 + F1Race_Ctz64(bits);
+}
+
+static void F1Race_Lane_Insert(F1RACE_TRAFFIC *traffic, int16_t car, int16_t above, int16_t below) {
+	uint8_t lane = traffic->road_id[car];
+	traffic->previous[car] = above;
+	traffic->next[car] = below;
+	if (above >= 0)
+		traffic->next[above] = car;
+	else
+		traffic->head[lane] = car;
+	if (below >= 0)
+		traffic->previous[below] = car;
+	else
+		traffic->tail[lane] = car;
+}
+
+static void F1Race_Lane_Remove(F1RACE_TRAFFIC *traffic, int16_t car) {
+	uint8_t lane = traffic->road_id[car];
+	int16_t above = traffic->previous[car];
+	int16_t below = traffic->next[car];
+	if (above >= 0)
+		traffic->next[above] = below;
+	else
+		traffic->head[lane] = below;
+	if (below >= 0)
+		traffic->previous[below] = above;
+	else
+		traffic->tail[lane] = above;
+}
+
+/* New cars appear at the top of the road, so the walk from the head stops after a few cars. */
+static void F1Race_Traffic_Link(F1RACE_TRAFFIC *traffic, int16_t car) {
+	int16_t above = -1;
+	int16_t below = traffic->head[traffic->road_id[car]];
+	while (below >= 0 && traffic->pos_y[below] < traffic->pos_y[car]) {
+		above = below;
+		below = traffic->next[below];
+	}
+	F1Race_Lane_Insert(traffic, car, above, below);
+}
+
+/* A faster car overtaking a slower one is moved up past it, lanes are almost sorted after every move. */
+static void F1Race_Lane_Sort(F1RACE_TRAFFIC *traffic, int16_t lane) {
+	int16_t car, following, above;
+	for (car = traffic->head[lane]; car >= 0; car = following) {
+		following = traffic->next[car];
+		above = traffic->previous[car];
+		if (above < 0 || traffic->pos_y[above] <= traffic->pos_y[car])
+			continue;
+		F1Race_Lane_Remove(traffic, car);
+		while (above >= 0 && traffic->pos_y[above] > traffic->pos_y[car])
+			above = traffic->previous[above];
+		F1Race_Lane_Insert(traffic, car, above, (above >= 0) ? traffic->next[above] : traffic->head[lane]);
+	}
+}
+
+static void F1Race_Traffic_Retire(F1RACE_TRAFFIC *traffic, int16_t car, uint8_t scanned) {
+	if (!scanned)
+		F1Race_Lane_Remove(traffic, car);
+	traffic->active[car >> 6] &= ~F1RACE_TRAFFIC_BIT(car);
+	traffic->speed[car] = 0;
+	traffic->dy[car] = 0;
+}
+
+static int16_t F1Race_Popcount64(uint64_t value) {
+#if defined(__GNUC__)
+	return (int16_t) __builtin_popcountll(value);
+#else
+	int16_t count = 0;
+	for (; value != 0; value &= value - 1)
+		count++;
+	return count;
+#endif
+}
+
+static int16_t F1Race_Msb64(uint64_t value) {
+#if defined(__GNUC__)
+	return (int16_t) (63 - __builtin_clzll(value));
+#else
+	int16_t index = 63;
+	while ((value >> index) == 0)
+		index--;
+	return index;
+#endif
+}
+
+/* Board rows of the screen rows "y" to "y + rows - 1" clipped to the boards, zero if none of them is on it. */
+static int F1Race_Bitboard_Rows(int y, int rows, int *first, int *last) {
+	*first = y - F1RACE_BITBOARD_TOP_Y;
+	*last = *first + rows - 1;
+	if (*first < 0)
+		*first = 0;
+	if (*last >= F1RACE_BITBOARD_ROWS)
+		*last = F1RACE_BITBOARD_ROWS - 1;
+	return *first <= *last;
+}
+
+/* Bits of the board rows "first" to "last" which are in word "word". */
+static uint64_t F1Race_Bitboard_Bits(int word, int first, int last) {
+	int low = first - word * 64;
+	int high = last - word * 64;
+	if (low < 0)
+		low = 0;
+	if (high > 63)
+		high = 63;
+	return (~0ull << low) & (~0ull >> (63 - high));
+}
+
+static void F1Race_Bitboard_Set(uint64_t *board, int y, int rows) {
+	int first = y - F1RACE_BITBOARD_TOP_Y, last, word;
+	uint64_t bits;
+	if (first >= 0 && rows >= 0 && rows < 64) {
+		/* Rows past the boards go to the spare word, cars below the boards add no bits. */
+		bits = (first < F1RACE_BITBOARD_ROWS) ? (1ull << rows) - 1 : 0;
+		first = (first < F1RACE_BITBOARD_ROWS) ? first : F1RACE_BITBOARD_ROWS - 1;
+		board[first >> 6] |= bits << (first & 63);
+		board[(first >> 6) + 1] |= (bits >> 1) >> (63 - (first & 63));
+		return;
+	}
+	if (!F1Race_Bitboard_Rows(y, rows, &first, &last))
+		return;
+	for (word = first >> 6; word <= last >> 6; word++)
+		board[word] |= F1Race_Bitboard_Bits(word, first, last);
+}
+
+/* Board of a lane, rebuilt first when a tick has moved the cars since the last query. */
+static const uint64_t *F1Race_Bitboard_Lane(F1RACE_STATE *state, int16_t lane) {
+	if (state->bitboards_dirty)
+		F1Race_Bitboard_Update(state);
+	return state->bitboards.lanes[lane];
+}
+
+int F1Race_Lane_Is_Clear(F1RACE_STATE *state, int16_t lane, int16_t y, int16_t rows) {
+	const uint64_t *board = F1Race_Bitboard_Lane(state, lane);
+	int first, last, word;
+	if (!F1Race_Bitboard_Rows(y, rows, &first, &last))
+		return 1;
+	for (word = first >> 6; word <= last >> 6; word++)
+		if (board[word] & F1Race_Bitboard_Bits(word, first, last))
+			return 0;
+	return 1;
+}
+
+int16_t F1Race_Lane_Occupied(F1RACE_STATE *state, int16_t lane, int16_t y, int16_t rows) {
+	const uint64_t *board = F1Race_Bitboard_Lane(state, lane);
+	int first, last, word;
+	int16_t count = 0;
+	if (!F1Race_Bitboard_Rows(y, rows, &first, &last))
+		return 0;
+	for (word = first >> 6; word <= last >> 6; word++)
+		count += F1Race_Popcount64(board[word] & F1Race_Bitboard_Bits(word, first, last));
+	return count;
+}
+
+/* The lowest occupied row above the player car is the highest set bit below its top row. */
+int16_t F1Race_Lane_Gap(F1RACE_STATE *state, int16_t lane) {
+	const uint64_t *board = F1Race_Bitboard_Lane(state, lane);
+	int first, last, word;
+	uint64_t bits;
+	if (!F1Race_Bitboard_Rows(F1RACE_BITBOARD_TOP_Y, state->player_car.pos_y - F1RACE_BITBOARD_TOP_Y, &first, &last))
+		return 0;
+	for (word = last >> 6; word >= 0; word--) {
+		bits = board[word] & F1Race_Bitboard_Bits(word, first, last);
+		if (bits != 0)
+			return (int16_t) (last - word * 64 - F1Race_Msb64(bits));
+	}
+	return (int16_t) (last - first + 1);
+}
+
+uint32_t F1Race_Player_Lanes(const F1RACE_STATE *state) {
+	const F1RACE_TRAFFIC *traffic = &state->traffic;
+	const F1RACE_CAR_STRUCT *player = &state->player_car;
+	uint32_t lanes = 0;
+	int16_t lane;
+	for (lane = 0; lane < state->traffic_config.lanes; lane++)
+		if (traffic->lane_x[lane] < player->pos_x + player->dx && player->pos_x < traffic->lane_x[lane + 1])
+			lanes |= 1u << lane;
+	return lanes;
+}
+
+/*
+ * Boards are rebuilt from the cars, free slots have no height so scanned traffic sets them all without a
+ * branch. A lane walk from the bottom ends at the first car above the boards.
+ */
+void F1Race_Bitboard_Update(F1RACE_STATE *state) {
+	F1RACE_BITBOARDS *boards = &state->bitboards;
+	const F1RACE_TRAFFIC *traffic = &state->traffic;
+	const F1RACE_TRAFFIC_CONFIG *config = &state->traffic_config;
+	int16_t lane, car, word;
+	int first;
+	uint64_t bits, *board;
+
+	state->bitboards_dirty = 0;
+	for (word = 0; word <= F1RACE_BITBOARD_WORDS; word++) {
+		for (lane = 0; lane < config->lanes; lane++)
+			boards->lanes[lane][word] = 0;
+		boards->player[word] = 0;
+	}
+	F1Race_Bitboard_Set(boards->player, state->player_car.pos_y, state->player_car.dy);
+
+	/* The two word writes of F1Race_Bitboard_Set() inline, cars above the boards or too tall take the call. */
+	if (F1RACE_TRAFFIC_SCANNED(config)) {
+		for (car = 0; car < F1RACE_TRAFFIC_SCAN_CARS; car++) {
+			board = boards->lanes[traffic->road_id[car]];
+			first = traffic->pos_y[car] - F1RACE_BITBOARD_TOP_Y;
+			if (first < 0 || traffic->dy[car] >= 64) {
+				F1Race_Bitboard_Set(board, traffic->pos_y[car], traffic->dy[car]);
+				continue;
+			}
+			bits = (first < F1RACE_BITBOARD_ROWS) ? (1ull << traffic->dy[car]) - 1 : 0;
+			first = (first < F1RACE_BITBOARD_ROWS) ? first : F1RACE_BITBOARD_ROWS - 1;
+			board[first >> 6] |= bits << (first & 63);
+			board[(first >> 6) + 1] |= (bits >> 1) >> (63 - (first & 63));
+		}
+		return;
+	}
+	for (lane = 0; lane < config->lanes; lane++)
+		for (car = traffic->tail[lane]; car >= 0 && traffic->pos_y[car] + traffic->max_dy > F1RACE_BITBOARD_TOP_Y;
+				car = traffic->previous[car])
+			F1Race_Bitboard_Set(boards->lanes[lane], traffic->pos_y[car], traffic->dy[car]);
+}
+
+/* Lanes with a car on a row of the player car, a crash needs one of them. */
+static uint32_t F1Race_Bitboard_Touching(const F1RACE_STATE *state) {
+	const F1RACE_BITBOARDS *boards = &state->bitboards;
+	uint32_t lanes = 0;
+	uint64_t bits;
+	int16_t lane, word;
+	int first, last;
+	F1Race_Bitboard_Rows(state->player_car.pos_y, state->player_car.dy, &first, &last);
+	for (lane = 0; lane < state->traffic_config.lanes; lane++) {
+		bits = 0;
+		for (word = first >> 6; word <= last >> 6; word++)
+			bits |= boards->lanes[lane][word] & boards->player[word];
+		if (bits != 0)
+			lanes |= 1u << lane;
+	}
+	return lanes;
+}
+
+/* A new car keeps its distance from the top rows of the road, or of its lane only with "lane_spacing". */
+static int16_t F1Race_Traffic_Space(F1RACE_STATE *state, uint8_t road) {
+	const F1RACE_TRAFFIC *traffic = &state->traffic;
+	const F1RACE_TRAFFIC_CONFIG *config = &state->traffic_config;
+	int16_t lane, car, word;
+	uint64_t bits;
+
+	if (F1RACE_TRAFFIC_SCANNED(config)) {
+		for (bits = traffic->active[0]; bits != 0; bits &= bits - 1) {
+			car = F1Race_Ctz64(bits);
+			if ((config->lane_spacing == 0 || traffic->road_id[car] == road) &&
+				(traffic->pos_y[car] + config->depth < F1RACE_SPAWN_SPACE))
+				return 0;
+		}
+		return 1;
+	}
+
+	/* Without depth every car starts on the boards, so a car in the top rows is a set bit of them. */
+	if (config->depth == 0 && F1RACE_DISPLAY_START_Y - traffic->max_dy >= F1RACE_BITBOARD_TOP_Y) {
+		bits = 0;
+		for (lane = 0; lane < config->lanes; lane++)
+			if (config->lane_spacing == 0 || lane == road)
+				for (word = 0; word <= F1RACE_SPAWN_ROWS >> 6; word++)
+					bits |= F1Race_Bitboard_Lane(state, lane)[word] & F1Race_Bitboard_Bits(word, 0, F1RACE_SPAWN_ROWS);
+		return bits == 0;
+	}
+
+	/* The head of a lane is its topmost car. */
+	for (lane = 0; lane < config->lanes; lane++) {
+		car = traffic->head[lane];
+		if ((config->lane_spacing == 0 || lane == road) && car >= 0 &&
+			(traffic->pos_y[car] + config->depth < F1RACE_SPAWN_SPACE))
+			return 0;
+	}
+	return 1;
+}
+
+void F1Race_Traffic_Classic(F1RACE_TRAFFIC_CONFIG *config) {
+	config->lanes = F1RACE_CLASSIC_LANES;
+	config->capacity = F1RACE_CLASSIC_CARS;
+	config->depth = 0;
+	config->spawns = 1;
+	config->lane_spacing = 0;
+}
+
+/* First field of "LANES,CARS,DEPTH,SPAWNS" out of its range. */
+static F1RACE_TRAFFIC_ERROR F1Race_Traffic_Range(const long *values) {
+	if (values[0] < 1 || values[0] > F1RACE_MAX_LANES)
+		return F1RACE_TRAFFIC_LANES;
+	if (values[1] < 1 || values[1] > F1RACE_OPPOSITE_CAR_COUNT)
+		return F1RACE_TRAFFIC_CARS;
+	if (values[2] < 0 || values[2] > F1RACE_MAX_TRAFFIC_DEPTH)
+		return F1RACE_TRAFFIC_DEPTH;
+	if (values[3] < 1 || values[3] > F1RACE_MAX_LANES)
+		return F1RACE_TRAFFIC_SPAWNS;
+	return F1RACE_TRAFFIC_OK;
+}
+
+static int F1Race_Traffic_Valid(const F1RACE_TRAFFIC_CONFIG *config) {
+	long values[4];
+	values[0] = config->lanes;
+	values[1] = config->capacity;
+	values[2] = config->depth;
+	values[3] = config->spawns;
+	return F1Race_Traffic_Range(values) == F1RACE_TRAFFIC_OK;
+}
+
+/* Stress traffic from "LANES,CARS[,DEPTH[,SPAWNS]]", depth defaults to 0 and spawns to 1. */
+F1RACE_TRAFFIC_ERROR F1Race_Traffic_Parse(F1RACE_TRAFFIC_CONFIG *config, const char *text) {
+	long values[4] = { 0, 0, 0, 1 };
+	F1RACE_TRAFFIC_ERROR error;
+	char *end;
+	int count = 0;
+	for (;;) {
+		values[count++] = strtol(text, &end, 10);
+		if (end == text)
+			return F1RACE_TRAFFIC_SYNTAX;
+		if (*end == '\0')
+			break;
+		if (*end != ',' || count == 4)
+			return F1RACE_TRAFFIC_SYNTAX;
+		text = end + 1;
+	}
+	if (count < 2)
+		return F1RACE_TRAFFIC_SYNTAX;
+	error = F1Race_Traffic_Range(values);
+	if (error != F1RACE_TRAFFIC_OK)
+		return error;
+	config->lanes = (int16_t) values[0];
+	config->capacity = (int16_t) values[1];
+	config->depth = (int16_t) values[2];
+	config->spawns = (int16_t) values[3];
+	config->lane_spacing = 1;
+	return F1RACE_TRAFFIC_OK;
+}
+
+/* What is wrong with a traffic text, front-ends print it along with the limits of the build. */
+const char *F1Race_Traffic_Error(F1RACE_TRAFFIC_ERROR error) {
+	switch (error) {
+		case F1RACE_TRAFFIC_OK:
+			return "no error";
+		case F1RACE_TRAFFIC_LANES:
+			return "too few or too many lanes";
+		case F1RACE_TRAFFIC_CARS:
+			return "too few or too many cars";
+		case F1RACE_TRAFFIC_DEPTH:
+			return "depth out of range";
+		case F1RACE_TRAFFIC_SPAWNS:
+			return "too few or too many spawns";
+		default:
+			return "expected LANES,CARS[,DEPTH[,SPAWNS]]";
+	}
+}
+
+/* Left edge of a lane, lanes past the last one start at the right edge of the road. */
+static int16_t F1Race_Lane_X(int16_t lanes, int16_t lane) {
+	return F1RACE_ROAD_0_START_X + ((lane < lanes) ? lane : lanes) * F1RACE_ROAD_SPAN / lanes;
+}
+
+/*
+ * Checks everything of a state from outside the game which indexes arrays or draws numbers: traffic settings,
+ * counters, lanes, types and sizes of cars, and the lane lists, which must hold every active car of a lane
+ * exactly once, sorted top to bottom. The ruleset pointer is not checked.
+ */
+int F1Race_State_Valid(const F1RACE_STATE *state) {
+	const F1RACE_TRAFFIC_CONFIG *config = &state->traffic_config;
+	const F1RACE_TRAFFIC *traffic = &state->traffic;
+	int16_t lane, car, above, count, active = 0;
+
+	if (!F1Race_Traffic_Valid(config) || state->level < 1 || state->level > F1RACE_MAX_LEVEL ||
+		state->score < 0 || state->pass < 0 || state->fly_count < 0 || state->fly_count > F1RACE_MAX_FLY_COUNT ||
+		state->last_car_road < 0 || state->last_car_road >= config->lanes ||
+		state->player_car.dx != F1RACE_PLAYER_CAR_IMAGE_SIZE_X || state->player_car.dy != F1RACE_PLAYER_CAR_IMAGE_SIZE_Y ||
+		traffic->max_dy < 0 || traffic->max_dy > F1RACE_MAX_CAR_DY)
+		return 0;
+	for (lane = 0; lane <= F1RACE_MAX_LANES; lane++)
+		if (traffic->lane_x[lane] != F1Race_Lane_X(config->lanes, lane))
+			return 0;
+	for (car = 0; car < F1RACE_OPPOSITE_CAR_COUNT; car++) {
+		if (!F1RACE_TRAFFIC_IS_ACTIVE(traffic, car)) {
+			if (traffic->speed[car] != 0 || traffic->dy[car] != 0)
+				return 0;
+			continue;
+		}
+		if (car >= config->capacity || traffic->road_id[car] >= config->lanes ||
+			traffic->image[car] >= F1RACE_OPPOSITE_CAR_TYPE_COUNT || traffic->dx[car] < 1 ||
+			traffic->dx[car] > F1RACE_ROAD_WIDTH || traffic->dy[car] < 1 || traffic->dy[car] > traffic->max_dy ||
+			traffic->speed[car] < 1 || traffic->speed[car] > 2 * F1RACE_MAX_CAR_SPEED)
+			return 0;
+		active++;
+	}
+	if (F1RACE_TRAFFIC_SCANNED(config))
+		return 1;
+
+	/* A list walk stops after as many cars as are active, so links in a loop cannot keep it going. */
+	count = 0;
+	for (lane = 0; lane < F1RACE_MAX_LANES; lane++) {
+		if (lane >= config->lanes) {
+			if (traffic->head[lane] != -1 || traffic->tail[lane] != -1)
+				return 0;
+			continue;
+		}
+		above = -1;
+		for (car = traffic->head[lane]; car != -1; car = traffic->next[car]) {
+			if (car < 0 || car >= config->capacity || count++ == active || !F1RACE_TRAFFIC_IS_ACTIVE(traffic, car) ||
+				traffic->road_id[car] != lane || traffic->previous[car] != above ||
+				(above >= 0 && traffic->pos_y[above] > traffic->pos_y[car]))
+				return 0;
+			above = car;
+		}
+		if (traffic->tail[lane] != above)
+			return 0;
+	}
+	return count == active;
+}
+
+/* Takes effect on the next F1Race_Init(). */
+int F1Race_Configure(F1RACE_STATE *state, const F1RACE_TRAFFIC_CONFIG *config) {
+	if (!F1Race_Traffic_Valid(config))
+		return 0;
+	state->traffic_config = *config;
+	return 1;
+}
+
+/* F1Race_Rules_Compile() of F1Race_Rules_Classic(), kept compiled so no game or thread has to build it. */
+#define F1RACE_CLASSIC_SAMPLER_EARLY                   { 11, { 11, 8, 7, 10, 7, 7, 7 }, { 0, 0, 1, 1, 1, 1, 3 } }
+#define F1RACE_CLASSIC_SAMPLER_LATE                    { 11, { 7, 11, 8, 9, 7, 10, 7 }, { 2, 1, 1, 2, 3, 3, 5 } }
+
+static const F1RACE_RULESET F1Race_Classic_Ruleset = {
+	{
+		{ F1RACE_OPPOSITE_CAR_0_IMAGE_SIZE_X, F1RACE_OPPOSITE_CAR_0_IMAGE_SIZE_Y, 3, 0 },
+		{ F1RACE_OPPOSITE_CAR_1_IMAGE_SIZE_X, F1RACE_OPPOSITE_CAR_1_IMAGE_SIZE_Y, 4, 1 },
+		{ F1RACE_OPPOSITE_CAR_2_IMAGE_SIZE_X, F1RACE_OPPOSITE_CAR_2_IMAGE_SIZE_Y, 6, 2 },
+		{ F1RACE_OPPOSITE_CAR_3_IMAGE_SIZE_X, F1RACE_OPPOSITE_CAR_3_IMAGE_SIZE_Y, 3, 3 },
+		{ F1RACE_OPPOSITE_CAR_4_IMAGE_SIZE_X, F1RACE_OPPOSITE_CAR_4_IMAGE_SIZE_Y, 3, 4 },
+		{ F1RACE_OPPOSITE_CAR_5_IMAGE_SIZE_X, F1RACE_OPPOSITE_CAR_5_IMAGE_SIZE_Y, 5, 5 },
+		{ F1RACE_OPPOSITE_CAR_6_IMAGE_SIZE_X, F1RACE_OPPOSITE_CAR_6_IMAGE_SIZE_Y, 3, 6 }
+	},
+	F1RACE_OPPOSITE_CAR_0_IMAGE_SIZE_Y,
+	{ -1, 10, 20, 30, 40, 50, 60, 70, 100, -1 },
+	{ 0, 0, 1, 2, 3, 4, 5, 6, 7, 8 },
+	{
+		F1RACE_CLASSIC_SAMPLER_EARLY, F1RACE_CLASSIC_SAMPLER_EARLY, F1RACE_CLASSIC_SAMPLER_EARLY,
+		F1RACE_CLASSIC_SAMPLER_LATE, F1RACE_CLASSIC_SAMPLER_LATE, F1RACE_CLASSIC_SAMPLER_LATE,
+		F1RACE_CLASSIC_SAMPLER_LATE, F1RACE_CLASSIC_SAMPLER_LATE, F1RACE_CLASSIC_SAMPLER_LATE,
+		F1RACE_CLASSIC_SAMPLER_LATE
+	}
+};
+
+const F1RACE_RULESET *F1Race_Ruleset_Classic(void) {
+	return &F1Race_Classic_Ruleset;
+}
+
+/* Levels of the original game: passes to reach them and chances of car types out of 11 before and from level 3. */
+static const int16_t F1Race_Classic_Passes[F1RACE_MAX_LEVEL] = { 0, 10, 20, 30, 40, 50, 60, 70, 100 };
+static const uint16_t F1Race_Classic_Weights[2][F1RACE_OPPOSITE_CAR_TYPE_COUNT] = {
+	{ 2, 3, 1, 2, 1, 1, 1 },
+	{ 1, 2, 2, 2, 1, 2, 1 }
+};
+
+void F1Race_Rules_Classic(F1RACE_RULES *rules) {
+	int16_t level, index;
+
+	memset(rules, 0, sizeof(F1RACE_RULES));
+	for (index = 0; index < F1RACE_OPPOSITE_CAR_TYPE_COUNT; index++)
+		rules->types[index] = F1Race_Classic_Ruleset.types[index];
+	rules->levels = F1RACE_MAX_LEVEL;
+	for (level = 0; level < F1RACE_MAX_LEVEL; level++) {
+		rules->level_passes[level] = F1Race_Classic_Passes[level];
+		rules->speed_bonus[level] = level;
+		for (index = 0; index < F1RACE_OPPOSITE_CAR_TYPE_COUNT; index++)
+			rules->weights[level][index] = F1Race_Classic_Weights[level >= 2][index];
+	}
+}
+
+/* Reads up to "count" integers after the keyword of a line, returns how many there were or -1 on garbage. */
+static int F1Race_Rules_Values(const char *text, long *values, int count) {
+	char *end;
+	int found = 0;
+	for (;;) {
+		while (*text == ' ' || *text == '\t' || *text == '\r')
+			text++;
+		if (*text == '\0')
+			return found;
+		if (found == count)
+			return -1;
+		values[found++] = strtol(text, &end, 10);
+		if (end == text || values[found - 1] < 0 || values[found - 1] > UINT16_MAX)
+			return -1;
+		text = end;
+	}
+}
+
+/* Returns the number of the first bad line, 0 on success. */
+int F1Race_Rules_Parse(F1RACE_RULES *rules, const char *text, size_t size) {
+	char line[256];
+	long values[3 + F1RACE_OPPOSITE_CAR_TYPE_COUNT];
+	size_t start = 0, end, length;
+	int number = 0, count, index;
+	char *comment;
+
+	while (start < size) {
+		number++;
+		for (end = start; end < size && text[end] != '\n'; end++)
+			;
+		length = end - start;
+		if (length >= sizeof(line))
+			return number;
+		memcpy(line, text + start, length);
+		line[length] = '\0';
+		start = end + 1;
+
+		comment = strchr(line, '#');
+		if (comment != NULL)
+			*comment = '\0';
+		if (strncmp(line, "type ", 5) == 0) {
+			count = F1Race_Rules_Values(line + 5, values, 4);
+			if (count != 4 || values[0] >= F1RACE_OPPOSITE_CAR_TYPE_COUNT || values[3] > INT16_MAX)
+				return number;
+			rules->types[values[0]].dx = (int16_t) values[1];
+			rules->types[values[0]].dy = (int16_t) values[2];
+			rules->types[values[0]].speed = (int16_t) values[3];
+		} else if (strncmp(line, "levels ", 7) == 0) {
+			count = F1Race_Rules_Values(line + 7, values, 1);
+			if (count != 1 || values[0] > F1RACE_MAX_LEVEL)
+				return number;
+			rules->levels = (int16_t) values[0];
+		} else if (strncmp(line, "level ", 6) == 0) {
+			count = F1Race_Rules_Values(line + 6, values, 3 + F1RACE_OPPOSITE_CAR_TYPE_COUNT);
+			if (count != 3 + F1RACE_OPPOSITE_CAR_TYPE_COUNT || values[0] < 1 || values[0] > F1RACE_MAX_LEVEL ||
+				values[1] > INT16_MAX || values[2] > INT16_MAX)
+				return number;
+			rules->level_passes[values[0] - 1] = (int16_t) values[1];
+			rules->speed_bonus[values[0] - 1] = (int16_t) values[2];
+			for (index = 0; index < F1RACE_OPPOSITE_CAR_TYPE_COUNT; index++)
+				rules->weights[values[0] - 1][index] = (uint16_t) values[3 + index];
+		} else if (F1Race_Rules_Values(line, values, 0) != 0)
+			return number;
+	}
+	return 0;
+}
+
+/*
+ * Vose's alias method in integers: every column holds "total" chances, columns of types lighter than the
+ * average are topped up by the heaviest ones, so a draw is one column and one coin with no search.
+ */
+static void F1Race_Sampler_Build(F1RACE_SAMPLER *sampler, const uint16_t *weights) {
+	uint32_t height[F1RACE_OPPOSITE_CAR_TYPE_COUNT];
+	uint8_t small[F1RACE_OPPOSITE_CAR_TYPE_COUNT], large[F1RACE_OPPOSITE_CAR_TYPE_COUNT];
+	int16_t smalls = 0, larges = 0, index;
+	uint8_t light, heavy;
+
+	sampler->total = 0;
+	for (index = 0; index < F1RACE_OPPOSITE_CAR_TYPE_COUNT; index++)
+		sampler->total += weights[index];
+	for (index = 0; index < F1RACE_OPPOSITE_CAR_TYPE_COUNT; index++) {
+		height[index] = (uint32_t) weights[index] * F1RACE_OPPOSITE_CAR_TYPE_COUNT;
+		if (height[index] < sampler->total)
+			small[smalls++] = (uint8_t) index;
+		else
+			large[larges++] = (uint8_t) index;
+	}
+	while (smalls > 0 && larges > 0) {
+		light = small[--smalls];
+		heavy = large[--larges];
+		sampler->keep[light] = height[light];
+		sampler->alias[light] = heavy;
+		height[heavy] -= sampler->total - height[light];
+		if (height[heavy] < sampler->total)
+			small[smalls++] = heavy;
+		else
+			large[larges++] = heavy;
+	}
+	while (larges > 0) {
+		heavy = large[--larges];
+		sampler->keep[heavy] = sampler->total;
+		sampler->alias[heavy] = heavy;
+	}
+	while (smalls > 0) {
+		light = small[--smalls];
+		sampler->keep[light] = sampler->total;
+		sampler->alias[light] = light;
+	}
+}
+
+/* Checks the rules and builds the samplers and level tables, returns 0 on rules the game cannot play. */
+int F1Race_Rules_Compile(F1RACE_RULESET *ruleset, const F1RACE_RULES *rules) {
+	const F1RACE_OPPOSITE_CAR_TYPE_STRUCT *type;
+	uint32_t total;
+	int16_t level, row, index;
+
+	if (rules->levels < 1 || rules->levels > F1RACE_MAX_LEVEL || rules->level_passes[0] != 0)
+		return 0;
+	for (index = 0; index < F1RACE_OPPOSITE_CAR_TYPE_COUNT; index++) {
+		type = &rules->types[index];
+		if (type->dx < 1 || type->dx > F1RACE_ROAD_WIDTH || type->dy < 1 || type->dy > F1RACE_MAX_CAR_DY ||
+			type->speed < 1 || type->speed > F1RACE_MAX_CAR_SPEED)
+			return 0;
+	}
+	for (row = 0; row < rules->levels; row++) {
+		if (row > 0 && rules->level_passes[row] <= rules->level_passes[row - 1])
+			return 0;
+		if (rules->speed_bonus[row] < 0 || rules->speed_bonus[row] > F1RACE_MAX_CAR_SPEED)
+			return 0;
+		total = 0;
+		for (index = 0; index < F1RACE_OPPOSITE_CAR_TYPE_COUNT; index++)
+			total += rules->weights[row][index];
+		if (total == 0 || total > UINT16_MAX)
+			return 0;
+	}
+
+	/* Cleared first and filled field by field, so compiled rulesets compare and hash byte by byte. */
+	memset(ruleset, 0, sizeof(F1RACE_RULESET));
+	for (index = 0; index < F1RACE_OPPOSITE_CAR_TYPE_COUNT; index++) {
+		ruleset->types[index].dx = rules->types[index].dx;
+		ruleset->types[index].dy = rules->types[index].dy;
+		ruleset->types[index].speed = rules->types[index].speed;
+		ruleset->types[index].image = (uint8_t) index;
+		if (rules->types[index].dy > ruleset->max_dy)
+			ruleset->max_dy = rules->types[index].dy;
+	}
+	for (level = 0; level <= F1RACE_MAX_LEVEL; level++) {
+		row = (level < 1) ? 0 : (level > rules->levels) ? rules->levels - 1 : level - 1;
+		ruleset->next_pass[level] = (level >= 1 && level < rules->levels) ? rules->level_passes[level] : -1;
+		ruleset->speed_bonus[level] = rules->speed_bonus[row];
+		F1Race_Sampler_Build(&ruleset->samplers[level], rules->weights[row]);
+	}
+	return 1;
+}
+
+void F1Race_Set_Rules(F1RACE_STATE *state, const F1RACE_RULESET *ruleset) {
+	state->ruleset = ruleset;
+}
+
+/* One draw picks a column of the sampler by its high bits and a coin in the column by the rest. */
+int16_t F1Race_Sample(F1RACE_STATE *state, const F1RACE_SAMPLER *sampler) {
+	uint64_t scaled = (uint64_t) F1Race_Random(state) * F1RACE_OPPOSITE_CAR_TYPE_COUNT;
+	uint32_t column = (uint32_t) (scaled >> 32);
+	uint32_t coin = (uint32_t) (((scaled & 0xFFFFFFFFull) * sampler->total) >> 32);
+	return (coin < sampler->keep[column]) ? (int16_t) column : sampler->alias[column];
+}
+
+/* Lanes split the classic road width evenly, three lanes are the classic roads and separators. */
+static void F1Race_Init_Traffic(F1RACE_STATE *state) {
+	F1RACE_TRAFFIC *traffic = &state->traffic;
+	int16_t lanes = state->traffic_config.lanes;
+	int index;
+
+	for (index = 0; index <= F1RACE_MAX_LANES; index++)
+		traffic->lane_x[index] = F1Race_Lane_X(lanes, index);
+	for (index = 0; index < F1RACE_MAX_LANES; index++) {
+		traffic->head[index] = -1;
+		traffic->tail[index] = -1;
+	}
+	traffic->max_dy = state->ruleset->max_dy;
+
+	for (index = 0; index < F1RACE_TRAFFIC_WORDS; index++) {
+		traffic->active[index] = 0;
+		traffic->scored[index] = 0;
+	}
+	for (index = 0; index < F1RACE_OPPOSITE_CAR_COUNT; index++) {
+		traffic->pos_y[index] = 0;
+		traffic->speed[index] = 0;
+		traffic->dy[index] = 0;
+		traffic->road_id[index] = 0;
+	}
+}
+
+void F1Race_Init(F1RACE_STATE *state) {
+	int16_t index, word;
+
+	state->keys = 0;
+	state->events = 0;
+
+	state->separator_0_block_start_y = F1RACE_DISPLAY_START_Y;
+	state->separator_1_block_start_y = F1RACE_DISPLAY_START_Y + F1RACE_SEPARATOR_HEIGHT_SPACE * 3;
+	state->player_car.pos_x = ((F1RACE_ROAD_1_START_X + F1RACE_ROAD_1_END_X - F1RACE_PLAYER_CAR_IMAGE_SIZE_X) / 2);
+	state->player_car.dx = F1RACE_PLAYER_CAR_IMAGE_SIZE_X;
+	state->player_car.pos_y = F1RACE_DISPLAY_END_Y - F1RACE_PLAYER_CAR_IMAGE_SIZE_Y - 1;
+	state->player_car.dy = F1RACE_PLAYER_CAR_IMAGE_SIZE_Y;
+
+	F1Race_Init_Traffic(state);
+
+	state->is_crashing = 0;
+	state->crashing_count_down = 0;
+	state->last_car_road = 0;
+	state->player_is_car_fly = 0;
+	state->player_car_fly_duration = 0;
+	state->score = 0;
+	state->level = 1;
+	state->pass = 0;
+	state->fly_count = 1;
+	state->fly_charger_count = 0;
+
+	for (word = 0; word <= F1RACE_BITBOARD_WORDS; word++) {
+		for (index = 0; index < F1RACE_MAX_LANES; index++)
+			state->bitboards.lanes[index][word] = 0;
+		state->bitboards.player[word] = 0;
+	}
+	state->bitboards_dirty = 1;
+}
+
+static void F1Race_Crashing(F1RACE_STATE *state) {
+	state->events |= F1RACE_EVENT_CRASH;
+
+	state->is_crashing = 1;
+	state->crashing_count_down = F1RACE_CRASHING_COUNT_DOWN;
+}
+
+static void F1Race_Fly(F1RACE_STATE *state) {
+	if (state->player_is_car_fly != 0)
+		return;
+
+	if (state->fly_count > 0) {
+		state->events |= F1RACE_EVENT_FLY;
+		state->player_is_car_fly = 1;
+		state->player_car_fly_duration = 0;
+		state->fly_count--;
+	}
+}
+
+void F1Race_New_Opposite_Car(F1RACE_STATE *state) {
+	int16_t validIndex;
+	int16_t car_type;
+	uint8_t road;
+	int16_t car_shift;
+	int16_t enough_space;
+	F1RACE_TRAFFIC *traffic = &state->traffic;
+	const F1RACE_TRAFFIC_CONFIG *config = &state->traffic_config;
+	const F1RACE_RULESET *ruleset = state->ruleset;
+	const F1RACE_OPPOSITE_CAR_TYPE_STRUCT *type;
+
+	if (F1Race_Random_Below(state, F1RACE_OPPOSITE_CAR_DEFAULT_APPEAR_RATE) != 0)
+		return;
+
+	validIndex = F1Race_Traffic_Free(traffic, config->capacity);
+	if (validIndex < 0)
+		return;
+
+	road = F1Race_Random_Below(state, config->lanes);
+
+	if (road == state->last_car_road) {
+		road++;
+		road %= config->lanes;
+	}
+
+	car_type = F1Race_Sample(state, &ruleset->samplers[state->level]);
+
+	enough_space = F1Race_Traffic_Space(state, road);
+
+	if (enough_space == 0)
+		return;
+
+	type = &ruleset->types[car_type];
+	traffic->active[validIndex >> 6] |= F1RACE_TRAFFIC_BIT(validIndex);
+	traffic->scored[validIndex >> 6] &= ~F1RACE_TRAFFIC_BIT(validIndex);
+	traffic->dx[validIndex] = type->dx;
+	traffic->dy[validIndex] = type->dy;
+	traffic->speed[validIndex] = type->speed + ruleset->speed_bonus[state->level];
+	traffic->image[validIndex] = type->image;
+
+	car_shift = (traffic->lane_x[road + 1] - traffic->lane_x[road] - F1RACE_SEPARATOR_WIDTH - type->dx) / 2;
+
+	traffic->pos_x[validIndex] = traffic->lane_x[road] + car_shift;
+	traffic->pos_y[validIndex] = F1RACE_DISPLAY_START_Y - config->depth - type->dy;
+	traffic->road_id[validIndex] = road;
+	if (!F1RACE_TRAFFIC_SCANNED(config))
+		F1Race_Traffic_Link(traffic, validIndex);
+	if (state->bitboards_dirty == 0)
+		F1Race_Bitboard_Set(state->bitboards.lanes[road], traffic->pos_y[validIndex], traffic->dy[validIndex]);
+
+	state->last_car_road = road;
+}
+
+/* Scores a car the player has left behind, levels go up at the pass counts of the rules and every sixth pass charges a fly. */
+static void F1Race_Pass(F1RACE_STATE *state, int16_t car) {
+	state->events |= F1RACE_EVENT_PASS;
+	state->score++;
+	state->pass++;
+	state->traffic.scored[car >> 6] |= F1RACE_TRAFFIC_BIT(car);
+
+	if (state->pass == state->ruleset->next_pass[state->level])
+		state->level++;
+
+	state->fly_charger_count++;
+	if (state->fly_charger_count >= 6) {
+		if (state->fly_count < F1RACE_MAX_FLY_COUNT) {
+			state->fly_charger_count = 0;
+			state->fly_count++;
+		} else
+			state->fly_charger_count--;
+	}
+}
+
+/* Lowest slot of a crashing car in a group of boxes, "first" if none of them crashes in a lower slot. */
+static int16_t F1Race_Collision_First(const F1RACE_COLLISION_BOXES *cars, const F1RACE_COLLISION_BOX *player,
+		const int16_t *slots, int16_t count, int16_t first) {
+	uint32_t hits = F1Race_Collision_Hits(cars, player) & ((1u << count) - 1);
+	for (; hits != 0; hits &= hits - 1)
+		if (slots[F1Race_Ctz64(hits)] < first)
+			first = slots[F1Race_Ctz64(hits)];
+	return first;
+}
+
+/* Scanned traffic: every slot is a lane of one kernel call, free slots are masked out. */
+static int16_t F1Race_Collision_Scan(F1RACE_STATE *state, const F1RACE_COLLISION_BOX *player) {
+	int16_t index;
+	F1RACE_COLLISION_BOXES cars;
+	uint32_t active, hits, scoring;
+	const F1RACE_TRAFFIC *traffic = &state->traffic;
+
+	for (index = 0; index < F1RACE_COLLISION_LANES; index++) {
+		cars.min_x[index] = traffic->pos_x[index] - 1;
+		cars.max_x[index] = cars.min_x[index] + traffic->dx[index] - 1;
+		cars.min_y[index] = traffic->pos_y[index] - 1;
+		cars.max_y[index] = cars.min_y[index] + traffic->dy[index] - 1;
+	}
+
+	active = (uint32_t) traffic->active[0];
+	hits = F1Race_Collision_Hits(&cars, player) & active;
+	scoring = (hits != 0) ? active & ((hits & (0u - hits)) - 1) : active;
+	scoring &= ~(uint32_t) traffic->scored[0];
+	for (; scoring != 0; scoring &= scoring - 1) {
+		index = F1Race_Ctz64(scoring);
+		if (player->max_y < cars.min_y[index])
+			F1Race_Pass(state, index);
+	}
+	return (hits != 0) ? F1Race_Ctz64(hits) : -1;
+}
+
+/* Lane lists are walked up from the bottom, only cars which reach the player rows go to the kernel. */
+static int16_t F1Race_Collision_Lanes(F1RACE_STATE *state, const F1RACE_COLLISION_BOX *player) {
+	int16_t lane, car, crash, count = 0;
+	int16_t slots[F1RACE_COLLISION_LANES];
+	uint32_t touching;
+	F1RACE_COLLISION_BOXES cars;
+	const F1RACE_TRAFFIC *traffic = &state->traffic;
+	const F1RACE_TRAFFIC_CONFIG *config = &state->traffic_config;
+
+	crash = config->capacity;
+	if (state->bitboards_dirty)
+		F1Race_Bitboard_Update(state);
+	touching = F1Race_Bitboard_Touching(state);
+	for (lane = 0; lane < config->lanes; lane++) {
+		if (((touching >> lane) & 1) == 0)
+			continue;
+		for (car = traffic->tail[lane]; car >= 0 && traffic->pos_y[car] - 2 + traffic->max_dy >= player->min_y;
+				car = traffic->previous[car]) {
+			if (traffic->pos_y[car] - 1 > player->max_y)
+				continue;
+			cars.min_x[count] = traffic->pos_x[car] - 1;
+			cars.max_x[count] = cars.min_x[count] + traffic->dx[car] - 1;
+			cars.min_y[count] = traffic->pos_y[car] - 1;
+			cars.max_y[count] = cars.min_y[count] + traffic->dy[car] - 1;
+			slots[count++] = car;
+			if (count == F1RACE_COLLISION_LANES) {
+				crash = F1Race_Collision_First(&cars, player, slots, count, crash);
+				count = 0;
+			}
+		}
+	}
+	if (count != 0)
+		crash = F1Race_Collision_First(&cars, player, slots, count, crash);
+
+	for (lane = 0; lane < config->lanes; lane++) {
+		for (car = traffic->tail[lane]; car >= 0 && traffic->pos_y[car] - 1 > player->max_y; car = traffic->previous[car])
+			if (car < crash && ((traffic->scored[car >> 6] >> (car & 63)) & 1) == 0)
+				F1Race_Pass(state, car);
+	}
+	return (crash < config->capacity) ? crash : -1;
+}
+
+/*
+ * The old loop returned on the first crashing car in slot order, so only the cars in slots before it may
+ * still score their pass.
+ */
+void F1Race_CollisionCheck(F1RACE_STATE *state) {
+	F1RACE_COLLISION_BOX player;
+	int16_t crash;
+
+	player.min_x = state->player_car.pos_x - 1;
+	player.max_x = player.min_x + state->player_car.dx - 1;
+	player.min_y = state->player_car.pos_y - 1;
+	player.max_y = player.min_y + state->player_car.dy - 1;
+
+	if (F1RACE_TRAFFIC_SCANNED(&state->traffic_config))
+		crash = F1Race_Collision_Scan(state, &player);
+	else
+		crash = F1Race_Collision_Lanes(state, &player);
+	if (crash >= 0)
+		F1Race_Crashing(state);
+}
+
+static void F1Race_Separator_Move(F1RACE_STATE *state) {
+	state->separator_0_block_start_y += F1RACE_SEPARATOR_HEIGHT_SPACE;
+	if (state->separator_0_block_start_y >=
+		(F1RACE_DISPLAY_START_Y + F1RACE_SEPARATOR_HEIGHT_SPACE * F1RACE_SEPARATOR_RATIO))
+		state->separator_0_block_start_y = F1RACE_DISPLAY_START_Y;
+
+	state->separator_1_block_start_y += F1RACE_SEPARATOR_HEIGHT_SPACE;
+	if (state->separator_1_block_start_y >=
+		(F1RACE_DISPLAY_START_Y + F1RACE_SEPARATOR_HEIGHT_SPACE * F1RACE_SEPARATOR_RATIO))
+		state->separator_1_block_start_y = F1RACE_DISPLAY_START_Y;
+}
+
+void F1Race_Framemove(F1RACE_STATE *state) {
+	int16_t shift;
+	int16_t max;
+	int16_t index;
+	int16_t lane;
+	int16_t above;
+	int16_t word;
+	uint64_t bits;
+	uint8_t scanned = F1RACE_TRAFFIC_SCANNED(&state->traffic_config);
+	F1RACE_CAR_STRUCT *player = &state->player_car;
+	F1RACE_TRAFFIC *traffic = &state->traffic;
+	const F1RACE_TRAFFIC_CONFIG *config = &state->traffic_config;
+
+	state->player_car_fly_duration++;
+	if (state->player_car_fly_duration == F1RACE_PLAYER_CAR_FLY_FRAME_COUNT)
+		state->player_is_car_fly = 0;
+
+	shift = F1RACE_PLAYER_CAR_SHIFT;
+	if (state->keys & F1RACE_INPUT_UP) {
+		if (player->pos_y - shift < F1RACE_DISPLAY_START_Y)
+			shift = player->pos_y - F1RACE_DISPLAY_START_Y - 1;
+		if (state->player_is_car_fly == 0)
+			player->pos_y -= shift;
+	}
+
+	if (state->keys & F1RACE_INPUT_DOWN) {
+		max = player->pos_y + player->dy;
+		if (max + shift > F1RACE_DISPLAY_END_Y)
+			shift = F1RACE_DISPLAY_END_Y - max;
+		if (state->player_is_car_fly == 0)
+			player->pos_y += shift;
+	}
+
+	if (state->keys & F1RACE_INPUT_RIGHT) {
+		max = player->pos_x + player->dx;
+		if (max + shift > F1RACE_ROAD_2_END_X)
+			shift = F1RACE_ROAD_2_END_X - max;
+		player->pos_x += shift;
+	}
+
+	if (state->keys & F1RACE_INPUT_LEFT) {
+		if (player->pos_x - shift < F1RACE_ROAD_0_START_X)
+			shift = player->pos_x - F1RACE_ROAD_0_START_X - 1;
+		player->pos_x -= shift;
+	}
+
+	/* Free slots, also the ones past the capacity, have zero speed, so every slot moves without a branch. */
+	if (scanned) {
+		for (index = 0; index < F1RACE_TRAFFIC_SCAN_CARS; index++)
+			traffic->pos_y[index] += traffic->speed[index];
+	} else {
+		for (index = 0; index < config->capacity; index++)
+			traffic->pos_y[index] += traffic->speed[index];
+	}
+	for (word = 0; scanned && word < F1RACE_TRAFFIC_WORDS; word++) {
+		for (bits = traffic->active[word]; bits != 0; bits &= bits - 1) {
+			index = word * 64 + F1Race_Ctz64(bits);
+			if (traffic->pos_y[index] > (F1RACE_DISPLAY_END_Y + traffic->dy[index]))
+				F1Race_Traffic_Retire(traffic, index, scanned);
+		}
+	}
+	for (lane = 0; !scanned && lane < config->lanes; lane++) {
+		F1Race_Lane_Sort(traffic, lane);
+		for (index = traffic->tail[lane]; index >= 0 && traffic->pos_y[index] > F1RACE_DISPLAY_END_Y; index = above) {
+			above = traffic->previous[index];
+			if (traffic->pos_y[index] > (F1RACE_DISPLAY_END_Y + traffic->dy[index]))
+				F1Race_Traffic_Retire(traffic, index, scanned);
+		}
+	}
+
+	if (state->player_is_car_fly != 0) {
+		shift = F1RACE_PLAYER_CAR_FLY_SHIFT;
+		if (player->pos_y - shift < F1RACE_DISPLAY_START_Y)
+			shift = player->pos_y - F1RACE_DISPLAY_START_Y - 1;
+		player->pos_y -= shift;
+	}
+	state->bitboards_dirty = 1;
+
+	if (state->player_is_car_fly == 0) {
+		F1RACE_TRACE_BEGIN(collision);
+		F1Race_CollisionCheck(state);
+		F1RACE_TRACE_END(collision, F1RACE_TRACE_COLLISION);
+	}
+
+	{
+		F1RACE_TRACE_BEGIN(new_car);
+		for (index = 0; index < config->spawns; index++)
+			F1Race_New_Opposite_Car(state);
+		F1RACE_TRACE_END(new_car, F1RACE_TRACE_NEW_CAR);
+	}
+	F1Race_Separator_Move(state);
+}
+
+uint32_t F1Race_Step(F1RACE_STATE *state, uint8_t input) {
+	state->events = 0;
+	if (state->is_crashing == 0) {
+		state->keys = input & F1RACE_INPUT_DIRECTIONS;
+		if (input & F1RACE_INPUT_FLY)
+			F1Race_Fly(state);
+		{
+			F1RACE_TRACE_BEGIN(framemove);
+			F1Race_Framemove(state);
+			F1RACE_TRACE_END(framemove, F1RACE_TRACE_FRAMEMOVE);
+		}
+	} else {
+		state->crashing_count_down--;
+		if (state->crashing_count_down == F1RACE_GAME_OVER_COUNT_DOWN - 1)
+			state->events |= F1RACE_EVENT_GAME_OVER;
+		if (state->crashing_count_down <= 0) {
+			F1Race_Init(state);
+			state->events |= F1RACE_EVENT_NEW_GAME;
+		}
+	}
+	return state->events;
+}
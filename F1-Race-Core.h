@@ -0,0 +1,298 @@
+/*
+ * About:
+ *   Headless and reentrant core of the "F1 Race" game: state, rules and logic without SDL.
+ *
+ * License:
+ *   MIT
+ */
+
+#ifndef F1_RACE_CORE_H
+#define F1_RACE_CORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define F1RACE_PLAYER_CAR_IMAGE_SIZE_X                 (15)
+#define F1RACE_PLAYER_CAR_IMAGE_SIZE_Y                 (20)
+#define F1RACE_PLAYER_CAR_CARSH_IMAGE_SIZE_X           (15)
+#define F1RACE_PLAYER_CAR_CARSH_IMAGE_SIZE_Y           (25)
+#define F1RACE_PLAYER_CAR_FLY_IMAGE_SIZE_X             (23)
+#define F1RACE_PLAYER_CAR_FLY_IMAGE_SIZE_Y             (27)
+#define F1RACE_PLAYER_CAR_HEAD_LIGHT_IMAGE_SIZE_X      (7)
+#define F1RACE_PLAYER_CAR_HEAD_LIGHT_IMAGE_SIZE_Y      (15)
+#define F1RACE_PLAYER_CAR_HEAD_LIGHT_0_SHIFT           (1)
+#define F1RACE_PLAYER_CAR_HEAD_LIGHT_1_SHIFT           (7)
+#define F1RACE_OPPOSITE_CAR_TYPE_COUNT                 (7)
+#define F1RACE_PLAYER_CAR_FLY_FRAME_COUNT              (10)
+#define F1RACE_OPPOSITE_CAR_0_IMAGE_SIZE_X             (17)
+#define F1RACE_OPPOSITE_CAR_0_IMAGE_SIZE_Y             (35)
+#define F1RACE_OPPOSITE_CAR_1_IMAGE_SIZE_X             (12)
+#define F1RACE_OPPOSITE_CAR_1_IMAGE_SIZE_Y             (18)
+#define F1RACE_OPPOSITE_CAR_2_IMAGE_SIZE_X             (15)
+#define F1RACE_OPPOSITE_CAR_2_IMAGE_SIZE_Y             (20)
+#define F1RACE_OPPOSITE_CAR_3_IMAGE_SIZE_X             (12)
+#define F1RACE_OPPOSITE_CAR_3_IMAGE_SIZE_Y             (18)
+#define F1RACE_OPPOSITE_CAR_4_IMAGE_SIZE_X             (17)
+#define F1RACE_OPPOSITE_CAR_4_IMAGE_SIZE_Y             (27)
+#define F1RACE_OPPOSITE_CAR_5_IMAGE_SIZE_X             (13)
+#define F1RACE_OPPOSITE_CAR_5_IMAGE_SIZE_Y             (21)
+#define F1RACE_OPPOSITE_CAR_6_IMAGE_SIZE_X             (13)
+#define F1RACE_OPPOSITE_CAR_6_IMAGE_SIZE_Y             (22)
+#define F1RACE_CLASSIC_CARS                            (8)
+#ifndef F1RACE_OPPOSITE_CAR_COUNT
+#define F1RACE_OPPOSITE_CAR_COUNT                      (F1RACE_CLASSIC_CARS) /* Capacity of the build. */
+#endif
+#define F1RACE_CLASSIC_LANES                           (3)
+#define F1RACE_MAX_LANES                               (16)
+#define F1RACE_MAX_TRAFFIC_DEPTH                       (16384)
+#define F1RACE_OPPOSITE_CAR_DEFAULT_APPEAR_RATE        (2)
+#define F1RACE_MAX_LEVEL                               (9) /* The status bar draws a single digit. */
+#define F1RACE_MAX_CAR_DY                              (63)
+#define F1RACE_MAX_CAR_SPEED                           (32)
+#define F1RACE_MAX_FLY_COUNT                           (9)
+#define F1RACE_PLAYER_CAR_SHIFT                        (5)
+#define F1RACE_PLAYER_CAR_FLY_SHIFT                    (2)
+#define F1RACE_CRASHING_COUNT_DOWN                     (50)
+#define F1RACE_GAME_OVER_COUNT_DOWN                    (40)
+#define F1RACE_DISPLAY_START_X                         (3)
+#define F1RACE_DISPLAY_START_Y                         (3)
+#define F1RACE_DISPLAY_END_X                           (124)
+#define F1RACE_DISPLAY_END_Y                           (124)
+#define F1RACE_ROAD_WIDTH                              (23)
+#define F1RACE_SEPARATOR_WIDTH                         (3)
+#define F1RACE_GRASS_WIDTH                             (7)
+#define F1RACE_STATUS_WIDTH                            (32)
+#define F1RACE_SEPARATOR_HEIGHT_SPACE                  (3)
+#define F1RACE_SEPARATOR_RATIO                         (6)
+#define F1RACE_SEPARATOR_HEIGHT                        (F1RACE_SEPARATOR_HEIGHT_SPACE*F1RACE_SEPARATOR_RATIO)
+#define F1RACE_STATUS_NUMBER_WIDTH                     (4)
+#define F1RACE_STATUS_NUBBER_HEIGHT                    (7)
+#define F1RACE_GRASS_0_START_X                         (F1RACE_DISPLAY_START_X)
+#define F1RACE_GRASS_0_END_X                           (F1RACE_GRASS_0_START_X + F1RACE_GRASS_WIDTH)-1
+#define F1RACE_ROAD_0_START_X                          (F1RACE_GRASS_0_START_X + F1RACE_GRASS_WIDTH)
+#define F1RACE_ROAD_0_END_X                            (F1RACE_ROAD_0_START_X + F1RACE_ROAD_WIDTH)-1
+#define F1RACE_SEPARATOR_0_START_X                     (F1RACE_ROAD_0_START_X + F1RACE_ROAD_WIDTH)
+#define F1RACE_SEPARATOR_0_END_X                       (F1RACE_SEPARATOR_0_START_X + F1RACE_SEPARATOR_WIDTH)-1
+#define F1RACE_ROAD_1_START_X                          (F1RACE_SEPARATOR_0_START_X + F1RACE_SEPARATOR_WIDTH)
+#define F1RACE_ROAD_1_END_X                            (F1RACE_ROAD_1_START_X + F1RACE_ROAD_WIDTH)-1
+#define F1RACE_SEPARATOR_1_START_X                     (F1RACE_ROAD_1_START_X + F1RACE_ROAD_WIDTH)
+#define F1RACE_SEPARATOR_1_END_X                       (F1RACE_SEPARATOR_1_START_X + F1RACE_SEPARATOR_WIDTH)-1
+#define F1RACE_ROAD_2_START_X                          (F1RACE_SEPARATOR_1_START_X + F1RACE_SEPARATOR_WIDTH)
+#define F1RACE_ROAD_2_END_X                            (F1RACE_ROAD_2_START_X + F1RACE_ROAD_WIDTH)-1
+#define F1RACE_GRASS_1_START_X                         (F1RACE_ROAD_2_START_X + F1RACE_ROAD_WIDTH)
+#define F1RACE_GRASS_1_END_X                           (F1RACE_GRASS_1_START_X + F1RACE_GRASS_WIDTH)-1
+#define F1RACE_STATUS_START_X                          (F1RACE_GRASS_1_START_X + F1RACE_GRASS_WIDTH)
+#define F1RACE_STATUS_END_X                            (F1RACE_STATUS_START_X + F1RACE_STATUS_WIDTH)
+#define F1RACE_ROAD_SPAN                               ((F1RACE_ROAD_WIDTH + F1RACE_SEPARATOR_WIDTH) * F1RACE_CLASSIC_LANES)
+
+/* Bits of the input mask passed to F1Race_Step(): held direction keys and a fly request. */
+typedef enum F1RACE_INPUTS {
+	F1RACE_INPUT_UP                                = 1 << 0,
+	F1RACE_INPUT_DOWN                              = 1 << 1,
+	F1RACE_INPUT_LEFT                              = 1 << 2,
+	F1RACE_INPUT_RIGHT                             = 1 << 3,
+	F1RACE_INPUT_FLY                               = 1 << 4,
+	F1RACE_INPUT_DIRECTIONS                        = 0x0F
+} F1RACE_INPUT;
+
+/* Bits of the event mask returned by F1Race_Step(), front-ends play sounds and switch screens on them. */
+typedef enum F1RACE_EVENTS {
+	F1RACE_EVENT_CRASH                             = 1 << 0,
+	F1RACE_EVENT_GAME_OVER                         = 1 << 1,
+	F1RACE_EVENT_NEW_GAME                          = 1 << 2,
+	F1RACE_EVENT_PASS                              = 1 << 3,
+	F1RACE_EVENT_FLY                               = 1 << 4
+} F1RACE_EVENT;
+
+typedef struct {
+	int16_t pos_x;
+	int16_t pos_y;
+	int16_t dx;
+	int16_t dy;
+} F1RACE_CAR_STRUCT;
+
+typedef struct {
+	int16_t dx;
+	int16_t dy;
+	int16_t speed;
+	uint8_t image;
+} F1RACE_OPPOSITE_CAR_TYPE_STRUCT;
+
+/*
+ * Rules of a game, the classic ones or loaded by F1Race_Rules_Parse(). Row N of the level tables is level
+ * N + 1: the passes which reach it, the speed bonus of the cars which appear on it, and the spawn weights
+ * of the car types. Car type N is drawn with opposite car image N.
+ */
+typedef struct {
+	F1RACE_OPPOSITE_CAR_TYPE_STRUCT types[F1RACE_OPPOSITE_CAR_TYPE_COUNT];
+	int16_t levels;
+	int16_t level_passes[F1RACE_MAX_LEVEL];
+	int16_t speed_bonus[F1RACE_MAX_LEVEL];
+	uint16_t weights[F1RACE_MAX_LEVEL][F1RACE_OPPOSITE_CAR_TYPE_COUNT];
+} F1RACE_RULES;
+
+/* Alias method: column N of "total" chances gives car type N for the first "keep[N]" of them, else "alias[N]". */
+typedef struct {
+	uint32_t total;
+	uint32_t keep[F1RACE_OPPOSITE_CAR_TYPE_COUNT];
+	uint8_t alias[F1RACE_OPPOSITE_CAR_TYPE_COUNT];
+} F1RACE_SAMPLER;
+
+/*
+ * Rules compiled by F1Race_Rules_Compile(), shared read-only by any number of games. Level tables are
+ * indexed by the level itself, "next_pass" is the pass count which takes a level to the next one, -1 on
+ * the last level. Levels past the last one repeat it.
+ */
+typedef struct {
+	F1RACE_OPPOSITE_CAR_TYPE_STRUCT types[F1RACE_OPPOSITE_CAR_TYPE_COUNT];
+	int16_t max_dy;
+	int16_t next_pass[F1RACE_MAX_LEVEL + 1];
+	int16_t speed_bonus[F1RACE_MAX_LEVEL + 1];
+	F1RACE_SAMPLER samplers[F1RACE_MAX_LEVEL + 1];
+} F1RACE_RULESET;
+
+#define F1RACE_TRAFFIC_WORDS                           ((F1RACE_OPPOSITE_CAR_COUNT + 63) / 64)
+#define F1RACE_TRAFFIC_IS_ACTIVE(traffic, index)       (((traffic)->active[(index) >> 6] >> ((index) & 63)) & 1)
+
+/*
+ * Traffic of a game. The classic one has three lanes, eight cars, and a car only appears when no car is in
+ * the top rows of the whole road. Stress traffic has up to F1RACE_MAX_LANES lanes sharing the same road width,
+ * up to F1RACE_OPPOSITE_CAR_COUNT cars, "depth" rows above the screen where cars already drive, "spawns" new
+ * car attempts per tick, and with "lane_spacing" a car only keeps its distance from cars of its own lane.
+ */
+typedef struct {
+	int16_t lanes;
+	int16_t capacity;
+	int16_t depth;
+	int16_t spawns;
+	uint8_t lane_spacing;
+} F1RACE_TRAFFIC_CONFIG;
+
+/* Result of F1Race_Traffic_Parse(): a malformed text or the first field out of its range. */
+typedef enum F1RACE_TRAFFIC_ERRORS {
+	F1RACE_TRAFFIC_OK,
+	F1RACE_TRAFFIC_SYNTAX,
+	F1RACE_TRAFFIC_LANES,
+	F1RACE_TRAFFIC_CARS,
+	F1RACE_TRAFFIC_DEPTH,
+	F1RACE_TRAFFIC_SPAWNS
+} F1RACE_TRAFFIC_ERROR;
+
+/*
+ * Opposite cars, one array per field: car N is element N of every array. Bit N of "active" is set while
+ * car N is on the road and bit N of "scored" once the player has passed it. Free slots keep a zero speed
+ * and height. Cars of large traffic are linked per lane from the top ("head") to the bottom ("tail") of the
+ * road sorted by "pos_y", so spawning, collisions and retirement only walk the cars near the top or bottom
+ * of each lane.
+ */
+typedef struct {
+	uint64_t active[F1RACE_TRAFFIC_WORDS];
+	uint64_t scored[F1RACE_TRAFFIC_WORDS];
+	int16_t head[F1RACE_MAX_LANES];
+	int16_t tail[F1RACE_MAX_LANES];
+	int16_t lane_x[F1RACE_MAX_LANES + 1];
+	int16_t max_dy;
+	int16_t next[F1RACE_OPPOSITE_CAR_COUNT];
+	int16_t previous[F1RACE_OPPOSITE_CAR_COUNT];
+	int16_t pos_x[F1RACE_OPPOSITE_CAR_COUNT];
+	int16_t pos_y[F1RACE_OPPOSITE_CAR_COUNT];
+	int16_t speed[F1RACE_OPPOSITE_CAR_COUNT];
+	int16_t dx[F1RACE_OPPOSITE_CAR_COUNT];
+	int16_t dy[F1RACE_OPPOSITE_CAR_COUNT];
+	uint8_t image[F1RACE_OPPOSITE_CAR_COUNT];
+	uint8_t road_id[F1RACE_OPPOSITE_CAR_COUNT];
+} F1RACE_TRAFFIC;
+
+#define F1RACE_BITBOARD_TOP_Y                          (-64)
+#define F1RACE_BITBOARD_ROWS                           (192)
+#define F1RACE_BITBOARD_WORDS                          (F1RACE_BITBOARD_ROWS / 64)
+
+/*
+ * Occupancy of the road rows from F1RACE_BITBOARD_TOP_Y down to the bottom of the screen: bit N of a lane
+ * board is set while a car of the lane covers the row F1RACE_BITBOARD_TOP_Y + N, the player board has the
+ * rows of the player car. Cars further above the screen are not on the boards. A spare word after the rows
+ * of every board takes the rows past them, so a car is added with two word writes. A tick only marks the
+ * boards dirty, the first lane query after it rebuilds them.
+ */
+typedef struct {
+	uint64_t lanes[F1RACE_MAX_LANES][F1RACE_BITBOARD_WORDS + 1];
+	uint64_t player[F1RACE_BITBOARD_WORDS + 1];
+} F1RACE_BITBOARDS;
+
+typedef struct F1Race_State {
+	uint64_t seed;
+	uint32_t random[4];
+	uint8_t is_crashing;
+	uint8_t player_is_car_fly;
+	uint8_t keys;
+	uint8_t bitboards_dirty;
+	int16_t crashing_count_down;
+	int16_t separator_0_block_start_y;
+	int16_t separator_1_block_start_y;
+	int16_t last_car_road;
+	int16_t player_car_fly_duration;
+	int16_t score;
+	int16_t level;
+	int16_t pass;
+	int16_t fly_count;
+	int16_t fly_charger_count;
+	uint32_t events;
+	F1RACE_CAR_STRUCT player_car;
+	const F1RACE_RULESET *ruleset;
+	F1RACE_TRAFFIC_CONFIG traffic_config;
+	F1RACE_TRAFFIC traffic;
+	F1RACE_BITBOARDS bitboards;
+} F1RACE_STATE;
+
+/*
+ * Seeding starts a session with the classic traffic and rules, F1Race_Configure() and F1Race_Set_Rules()
+ * before F1Race_Init() change them. The ruleset must outlive the session.
+ */
+void F1Race_Seed(F1RACE_STATE *state, uint64_t seed);
+uint32_t F1Race_Random(F1RACE_STATE *state);
+uint32_t F1Race_Random_Below(F1RACE_STATE *state, uint32_t bound);
+
+void F1Race_Traffic_Classic(F1RACE_TRAFFIC_CONFIG *config);
+F1RACE_TRAFFIC_ERROR F1Race_Traffic_Parse(F1RACE_TRAFFIC_CONFIG *config, const char *text);
+const char *F1Race_Traffic_Error(F1RACE_TRAFFIC_ERROR error);
+int F1Race_Configure(F1RACE_STATE *state, const F1RACE_TRAFFIC_CONFIG *config);
+
+/*
+ * Rules text has one setting per line, "#" starts a comment:
+ *   type INDEX DX DY SPEED
+ *   levels COUNT
+ *   level LEVEL PASSES BONUS WEIGHT_0 ... WEIGHT_6
+ * Parsing changes the given rules, so a file only lists what differs from the classic ones.
+ */
+void F1Race_Rules_Classic(F1RACE_RULES *rules);
+int F1Race_Rules_Parse(F1RACE_RULES *rules, const char *text, size_t size);
+int F1Race_Rules_Compile(F1RACE_RULESET *ruleset, const F1RACE_RULES *rules);
+const F1RACE_RULESET *F1Race_Ruleset_Classic(void);
+void F1Race_Set_Rules(F1RACE_STATE *state, const F1RACE_RULESET *ruleset);
+int16_t F1Race_Sample(F1RACE_STATE *state, const F1RACE_SAMPLER *sampler);
+
+void F1Race_Init(F1RACE_STATE *state);
+int F1Race_State_Valid(const F1RACE_STATE *state);
+uint32_t F1Race_Step(F1RACE_STATE *state, uint8_t input);
+
+/* First car on the road in slot "index" or above, -1 if there is none. */
+int16_t F1Race_Traffic_Next(const F1RACE_TRAFFIC *traffic, int16_t index);
+
+/*
+ * Lane queries on the bitboards, "y" and "rows" give screen rows, rows off the boards count as clear.
+ * F1Race_Lane_Gap() is the number of clear rows right above the player car, up to the top of the boards.
+ * F1Race_Player_Lanes() has bit N set when the player car overlaps lane N. Tools which place cars
+ * themselves call F1Race_Bitboard_Update(), queries rebuild the boards once after every tick.
+ */
+int F1Race_Lane_Is_Clear(F1RACE_STATE *state, int16_t lane, int16_t y, int16_t rows);
+int16_t F1Race_Lane_Occupied(F1RACE_STATE *state, int16_t lane, int16_t y, int16_t rows);
+int16_t F1Race_Lane_Gap(F1RACE_STATE *state, int16_t lane);
+uint32_t F1Race_Player_Lanes(const F1RACE_STATE *state);
+void F1Race_Bitboard_Update(F1RACE_STATE *state);
+
+/* Single phases of F1Race_Step(), exposed for the micro-benchmarks. */
+void F1Race_New_Opposite_Car(F1RACE_STATE *state);
+void F1Race_CollisionCheck(F1RACE_STATE *state);
+void F1Race_Framemove(F1RACE_STATE *state);
+
+#endif /* F1_RACE_CORE_H */
@@ -0,0 +1,90 @@
+/*
+ * About:
+ *   Per-frame draw command list of the "F1 Race" game: collects fills and sprite blits, sorts them by state
+ *   without breaking painter's order and leaves the submission to a renderer backend.
+ *
+ * License:
+ *   MIT
+ */
+
+#include "F1-Race-Draw.h"
+
+#include <stdlib.h>
+
+/* Sprites share one atlas texture, so all of them have the same state and batch together. */
+static uint32_t F1Race_Draw_State(uint8_t kind, uint32_t color) {
+	return (kind == F1RACE_DRAW_FILL) ? color : 0;
+}
+
+static int F1Race_Draw_Overlap(const F1RACE_DRAW_RECT *a, const F1RACE_DRAW_RECT *b) {
+	return a->x < b->x + b->w && b->x < a->x + a->w && a->y < b->y + b->h && b->y < a->y + a->h;
+}
+
+/*
+ * A command is placed one layer above every earlier overlapping command with another state and on the same
+ * layer as earlier overlapping commands with its own state, sorting by (layer, state, sequence) then keeps
+ * the result identical to drawing in submission order.
+ */
+static void F1Race_Draw_Push(F1RACE_DRAW_LIST *list, uint8_t kind, uint32_t color, uint16_t image,
+		int16_t x, int16_t y, int16_t w, int16_t h) {
+	F1RACE_DRAW_COMMAND *command;
+	const F1RACE_DRAW_COMMAND *other;
+	uint32_t state = F1Race_Draw_State(kind, color);
+	uint32_t index;
+	uint32_t layer = 0, other_layer;
+
+	if (list->count >= F1RACE_DRAW_MAX_COMMANDS || w <= 0 || h <= 0)
+		return;
+
+	command = &list->commands[list->count];
+	command->rect.x = x;
+	command->rect.y = y;
+	command->rect.w = w;
+	command->rect.h = h;
+	command->color = color;
+	command->image = image;
+	command->kind = kind;
+
+	for (index = 0; index < list->count; index++) {
+		other = &list->commands[index];
+		if (!F1Race_Draw_Overlap(&other->rect, &command->rect))
+			continue;
+		other_layer = other->layer;
+		if (other->kind != kind || F1Race_Draw_State(other->kind, other->color) != state)
+			other_layer++;
+		if (other_layer > layer)
+			layer = other_layer;
+	}
+	if (layer > 0xFF)
+		layer = 0xFF;
+
+	command->layer = (uint8_t) layer;
+	command->key = ((uint64_t) layer << 56) | ((uint64_t) kind << 48) | ((uint64_t) state << 16) | list->count;
+	list->count++;
+}
+
+void F1Race_Draw_Reset(F1RACE_DRAW_LIST *list) {
+	list->count = 0;
+}
+
+int F1Race_Draw_Full(const F1RACE_DRAW_LIST *list) {
+	return list->count >= F1RACE_DRAW_MAX_COMMANDS;
+}
+
+void F1Race_Draw_Fill(F1RACE_DRAW_LIST *list, uint32_t color, int16_t x, int16_t y, int16_t w, int16_t h) {
+	F1Race_Draw_Push(list, F1RACE_DRAW_FILL, color, 0, x, y, w, h);
+}
+
+void F1Race_Draw_Sprite(F1RACE_DRAW_LIST *list, uint16_t image, int16_t x, int16_t y, int16_t w, int16_t h) {
+	F1Race_Draw_Push(list, F1RACE_DRAW_SPRITE, 0, image, x, y, w, h);
+}
+
+static int F1Race_Draw_Compare(const void *a, const void *b) {
+	uint64_t x = ((const F1RACE_DRAW_COMMAND *) a)->key;
+	uint64_t y = ((const F1RACE_DRAW_COMMAND *) b)->key;
+	return (x > y) - (x < y);
+}
+
+void F1Race_Draw_Sort(F1RACE_DRAW_LIST *list) {
+	qsort(list->commands, list->count, sizeof(F1RACE_DRAW_COMMAND), F1Race_Draw_Compare);
+}
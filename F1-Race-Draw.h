@@ -0,0 +1,57 @@
+/*
+ * About:
+ *   Per-frame draw command list of the "F1 Race" game: collects fills and sprite blits, sorts them by state
+ *   without breaking painter's order and leaves the submission to a renderer backend.
+ *
+ * License:
+ *   MIT
+ */
+
+#ifndef F1_RACE_DRAW_H
+#define F1_RACE_DRAW_H
+
+#include <stdint.h>
+
+#define F1RACE_DRAW_MAX_COMMANDS                       (256)
+
+typedef enum F1RACE_DRAW_KINDS {
+	F1RACE_DRAW_FILL,
+	F1RACE_DRAW_SPRITE
+} F1RACE_DRAW_KIND;
+
+typedef struct {
+	int16_t x;
+	int16_t y;
+	int16_t w;
+	int16_t h;
+} F1RACE_DRAW_RECT;
+
+typedef struct {
+	uint64_t key;
+	F1RACE_DRAW_RECT rect;
+	uint32_t color;
+	uint16_t image;
+	uint8_t kind;
+	uint8_t layer;
+} F1RACE_DRAW_COMMAND;
+
+typedef struct {
+	uint32_t count;
+	F1RACE_DRAW_COMMAND commands[F1RACE_DRAW_MAX_COMMANDS];
+} F1RACE_DRAW_LIST;
+
+typedef struct {
+	uint32_t commands;
+	uint32_t draw_calls;
+	uint32_t state_changes;
+} F1RACE_DRAW_STATS;
+
+#define F1RACE_DRAW_RGB(r, g, b)                       (((uint32_t) (r) << 24) | ((uint32_t) (g) << 16) | ((b) << 8) | 0xFF)
+
+void F1Race_Draw_Reset(F1RACE_DRAW_LIST *list);
+int F1Race_Draw_Full(const F1RACE_DRAW_LIST *list);
+void F1Race_Draw_Fill(F1RACE_DRAW_LIST *list, uint32_t color, int16_t x, int16_t y, int16_t w, int16_t h);
+void F1Race_Draw_Sprite(F1RACE_DRAW_LIST *list, uint16_t image, int16_t x, int16_t y, int16_t w, int16_t h);
+void F1Race_Draw_Sort(F1RACE_DRAW_LIST *list);
+
+#endif /* F1_RACE_DRAW_H */
@@ -0,0 +1,76 @@
+/*
+ * About:
+ *   Read-only memory mapping of whole files for the "F1 Race" game, used by replays and asset packs.
+ *
+ * License:
+ *   MIT
+ */
+
+#include "F1-Race-File.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+int F1Race_File_Map(F1RACE_FILE_MAPPING *mapping, const char *path) {
+	mapping->data = NULL;
+	mapping->size = 0;
+	mapping->handle = NULL;
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	LARGE_INTEGER size;
+	if (file == INVALID_HANDLE_VALUE)
+		return 0;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return 0;
+	}
+	mapping->handle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping->handle == NULL)
+		return 0;
+	mapping->data = MapViewOfFile(mapping->handle, FILE_MAP_READ, 0, 0, 0);
+	if (mapping->data == NULL) {
+		CloseHandle(mapping->handle);
+		mapping->handle = NULL;
+		return 0;
+	}
+	mapping->size = (size_t) size.QuadPart;
+#else
+	struct stat info;
+	void *data;
+	int file = open(path, O_RDONLY);
+	if (file < 0)
+		return 0;
+	if (fstat(file, &info) != 0 || info.st_size == 0) {
+		close(file);
+		return 0;
+	}
+	data = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED)
+		return 0;
+	mapping->data = data;
+	mapping->size = (size_t) info.st_size;
+#endif
+	return 1;
+}
+
+void F1Race_File_Unmap(F1RACE_FILE_MAPPING *mapping) {
+	if (mapping->data == NULL)
+		return;
+#if defined(_WIN32)
+	UnmapViewOfFile(mapping->data);
+	CloseHandle(mapping->handle);
+#else
+	munmap((void *) mapping->data, mapping->size);
+#endif
+	mapping->data = NULL;
+	mapping->size = 0;
+	mapping->handle = NULL;
+}
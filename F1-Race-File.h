@@ -0,0 +1,23 @@
+/*
+ * About:
+ *   Read-only memory mapping of whole files for the "F1 Race" game, used by replays and asset packs.
+ *
+ * License:
+ *   MIT
+ */
+
+#ifndef F1_RACE_FILE_H
+#define F1_RACE_FILE_H
+
+#include <stddef.h>
+
+typedef struct {
+	const void *data;
+	size_t size;
+	void *handle;
+} F1RACE_FILE_MAPPING;
+
+int F1Race_File_Map(F1RACE_FILE_MAPPING *mapping, const char *path);
+void F1Race_File_Unmap(F1RACE_FILE_MAPPING *mapping);
+
+#endif /* F1_RACE_FILE_H */
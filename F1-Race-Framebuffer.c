@@ -0,0 +1,227 @@
+/*
+ * About:
+ *   Software renderer of the "F1 Race" game: rasterizes draw command lists into a CPU-side RGBA8888 buffer.
+ *
+ * License:
+ *   MIT
+ */
+
+#include "F1-Race-Framebuffer.h"
+
+#include <stddef.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define F1RACE_FRAMEBUFFER_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define F1RACE_FRAMEBUFFER_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__wasm_simd128__)
+#define F1RACE_FRAMEBUFFER_WASM_SIMD
+#include <wasm_simd128.h>
+#endif
+
+#define F1RACE_FRAMEBUFFER_MIN(a, b)                   (((a) < (b)) ? (a) : (b))
+#define F1RACE_FRAMEBUFFER_MAX(a, b)                   (((a) > (b)) ? (a) : (b))
+
+static void F1Race_Framebuffer_Blit_Row_Scalar(uint32_t *to, const uint32_t *from, int32_t count) {
+	int32_t i;
+	for (i = 0; i < count; i++)
+		if (from[i] & 0xFF)
+			to[i] = from[i];
+}
+
+#if defined(F1RACE_FRAMEBUFFER_SSE2)
+static void F1Race_Framebuffer_Blit_Row_SSE2(uint32_t *to, const uint32_t *from, int32_t count) {
+	const __m128i alpha = _mm_set1_epi32(0xFF);
+	const __m128i zero = _mm_setzero_si128();
+	int32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i source = _mm_loadu_si128((const __m128i *) (from + i));
+		__m128i target = _mm_loadu_si128((const __m128i *) (to + i));
+		__m128i transparent = _mm_cmpeq_epi32(_mm_and_si128(source, alpha), zero);
+		target = _mm_or_si128(_mm_and_si128(transparent, target), _mm_andnot_si128(transparent, source));
+		_mm_storeu_si128((__m128i *) (to + i), target);
+	}
+	F1Race_Framebuffer_Blit_Row_Scalar(to + i, from + i, count - i);
+}
+#endif
+
+#if defined(F1RACE_FRAMEBUFFER_AVX2)
+__attribute__((target("avx2")))
+static void F1Race_Framebuffer_Blit_Row_AVX2(uint32_t *to, const uint32_t *from, int32_t count) {
+	const __m256i alpha = _mm256_set1_epi32(0xFF);
+	const __m256i zero = _mm256_setzero_si256();
+	int32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256i source = _mm256_loadu_si256((const __m256i *) (from + i));
+		__m256i target = _mm256_loadu_si256((const __m256i *) (to + i));
+		__m256i transparent = _mm256_cmpeq_epi32(_mm256_and_si256(source, alpha), zero);
+		_mm256_storeu_si256((__m256i *) (to + i), _mm256_blendv_epi8(source, target, transparent));
+	}
+	/* Sprites are 4 to 24 pixels wide, a 4-pixel step keeps the scalar tail short. */
+	if (i + 4 <= count) {
+		__m128i source = _mm_loadu_si128((const __m128i *) (from + i));
+		__m128i target = _mm_loadu_si128((const __m128i *) (to + i));
+		__m128i transparent = _mm_cmpeq_epi32(_mm_and_si128(source, _mm256_castsi256_si128(alpha)),
+			_mm_setzero_si128());
+		_mm_storeu_si128((__m128i *) (to + i), _mm_blendv_epi8(source, target, transparent));
+		i += 4;
+	}
+	F1Race_Framebuffer_Blit_Row_Scalar(to + i, from + i, count - i);
+}
+#endif
+
+#if defined(F1RACE_FRAMEBUFFER_WASM_SIMD)
+static void F1Race_Framebuffer_Blit_Row_Wasm_SIMD(uint32_t *to, const uint32_t *from, int32_t count) {
+	const v128_t alpha = wasm_i32x4_splat(0xFF);
+	const v128_t zero = wasm_i32x4_splat(0);
+	int32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		v128_t source = wasm_v128_load(from + i);
+		v128_t target = wasm_v128_load(to + i);
+		v128_t transparent = wasm_i32x4_eq(wasm_v128_and(source, alpha), zero);
+		wasm_v128_store(to + i, wasm_v128_bitselect(target, source, transparent));
+	}
+	F1Race_Framebuffer_Blit_Row_Scalar(to + i, from + i, count - i);
+}
+#endif
+
+static F1RACE_FRAMEBUFFER_ROW_KERNEL F1Race_Framebuffer_Kernel(F1RACE_FRAMEBUFFER_KERNEL kernel) {
+	switch (kernel) {
+		case F1RACE_FRAMEBUFFER_KERNEL_SCALAR:
+			return F1Race_Framebuffer_Blit_Row_Scalar;
+#if defined(F1RACE_FRAMEBUFFER_SSE2)
+		case F1RACE_FRAMEBUFFER_KERNEL_SSE2:
+			return F1Race_Framebuffer_Blit_Row_SSE2;
+#endif
+#if defined(F1RACE_FRAMEBUFFER_AVX2)
+		case F1RACE_FRAMEBUFFER_KERNEL_AVX2:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2") ? F1Race_Framebuffer_Blit_Row_AVX2 : NULL;
+#endif
+#if defined(F1RACE_FRAMEBUFFER_WASM_SIMD)
+		case F1RACE_FRAMEBUFFER_KERNEL_WASM_SIMD:
+			return F1Race_Framebuffer_Blit_Row_Wasm_SIMD;
+#endif
+		default:
+			return NULL;
+	}
+}
+
+int F1Race_Framebuffer_Kernel_Available(F1RACE_FRAMEBUFFER_KERNEL kernel) {
+	return F1Race_Framebuffer_Kernel(kernel) != NULL;
+}
+
+const char *F1Race_Framebuffer_Kernel_Name(F1RACE_FRAMEBUFFER_KERNEL kernel) {
+	static const char *names[F1RACE_FRAMEBUFFER_KERNEL_COUNT] = { "scalar", "sse2", "avx2", "wasm-simd" };
+	return (kernel < F1RACE_FRAMEBUFFER_KERNEL_COUNT) ? names[kernel] : "unknown";
+}
+
+int F1Race_Framebuffer_Set_Kernel(F1RACE_FRAMEBUFFER *framebuffer, F1RACE_FRAMEBUFFER_KERNEL kernel) {
+	F1RACE_FRAMEBUFFER_ROW_KERNEL blit_row = F1Race_Framebuffer_Kernel(kernel);
+	if (blit_row == NULL)
+		return 0;
+	framebuffer->kernel = kernel;
+	framebuffer->blit_row = blit_row;
+	return 1;
+}
+
+/* Picks the widest kernel supported by the build and the CPU. */
+void F1Race_Framebuffer_Init(F1RACE_FRAMEBUFFER *framebuffer, uint32_t *pixels, int16_t width, int16_t height) {
+	int kernel;
+	framebuffer->pixels = pixels;
+	framebuffer->width = width;
+	framebuffer->height = height;
+	F1Race_Framebuffer_Clip(framebuffer, NULL);
+	for (kernel = F1RACE_FRAMEBUFFER_KERNEL_COUNT - 1; kernel >= 0; kernel--)
+		if (F1Race_Framebuffer_Set_Kernel(framebuffer, (F1RACE_FRAMEBUFFER_KERNEL) kernel))
+			break;
+}
+
+/* Like SDL_RenderSetClipRect(), NULL disables clipping. */
+void F1Race_Framebuffer_Clip(F1RACE_FRAMEBUFFER *framebuffer, const F1RACE_DRAW_RECT *clip) {
+	int16_t x0 = 0, y0 = 0, x1 = framebuffer->width, y1 = framebuffer->height;
+	if (clip != NULL) {
+		x0 = F1RACE_FRAMEBUFFER_MAX(clip->x, 0);
+		y0 = F1RACE_FRAMEBUFFER_MAX(clip->y, 0);
+		x1 = F1RACE_FRAMEBUFFER_MIN(clip->x + clip->w, framebuffer->width);
+		y1 = F1RACE_FRAMEBUFFER_MIN(clip->y + clip->h, framebuffer->height);
+	}
+	framebuffer->clip.x = x0;
+	framebuffer->clip.y = y0;
+	framebuffer->clip.w = F1RACE_FRAMEBUFFER_MAX(x1 - x0, 0);
+	framebuffer->clip.h = F1RACE_FRAMEBUFFER_MAX(y1 - y0, 0);
+}
+
+/* Like SDL_RenderClear(), ignores the clip rectangle. */
+void F1Race_Framebuffer_Clear(F1RACE_FRAMEBUFFER *framebuffer, uint32_t color) {
+	int32_t index, count = (int32_t) framebuffer->width * framebuffer->height;
+	for (index = 0; index < count; index++)
+		framebuffer->pixels[index] = color;
+}
+
+static int F1Race_Framebuffer_Intersect(const F1RACE_FRAMEBUFFER *framebuffer, const F1RACE_DRAW_RECT *rect,
+		int16_t *x0, int16_t *y0, int16_t *x1, int16_t *y1) {
+	const F1RACE_DRAW_RECT *clip = &framebuffer->clip;
+	*x0 = F1RACE_FRAMEBUFFER_MAX(rect->x, clip->x);
+	*y0 = F1RACE_FRAMEBUFFER_MAX(rect->y, clip->y);
+	*x1 = F1RACE_FRAMEBUFFER_MIN(rect->x + rect->w, clip->x + clip->w);
+	*y1 = F1RACE_FRAMEBUFFER_MIN(rect->y + rect->h, clip->y + clip->h);
+	return *x0 < *x1 && *y0 < *y1;
+}
+
+void F1Race_Framebuffer_Fill(F1RACE_FRAMEBUFFER *framebuffer, const F1RACE_DRAW_RECT *rect, uint32_t color) {
+	int16_t x0, y0, x1, y1, x, y;
+	uint32_t *row;
+	if (!F1Race_Framebuffer_Intersect(framebuffer, rect, &x0, &y0, &x1, &y1))
+		return;
+	for (y = y0; y < y1; y++) {
+		row = framebuffer->pixels + (int32_t) y * framebuffer->width;
+		for (x = x0; x < x1; x++)
+			row[x] = color;
+	}
+}
+
+/* Colour-keyed, sprites of the game only have fully transparent and fully opaque pixels. */
+void F1Race_Framebuffer_Blit(F1RACE_FRAMEBUFFER *framebuffer, const F1RACE_FRAMEBUFFER_ATLAS *atlas,
+		uint16_t image, int16_t x, int16_t y) {
+	const F1RACE_DRAW_RECT *source = &atlas->rects[image];
+	F1RACE_DRAW_RECT rect;
+	int16_t x0, y0, x1, y1, j;
+	const uint32_t *from;
+	uint32_t *to;
+
+	rect.x = x;
+	rect.y = y;
+	rect.w = source->w;
+	rect.h = source->h;
+	if (!F1Race_Framebuffer_Intersect(framebuffer, &rect, &x0, &y0, &x1, &y1))
+		return;
+
+	from = atlas->pixels + (int32_t) (source->y + y0 - y) * atlas->pitch + source->x + (x0 - x);
+	to = framebuffer->pixels + (int32_t) y0 * framebuffer->width + x0;
+	for (j = y0; j < y1; j++) {
+		framebuffer->blit_row(to, from, x1 - x0);
+		from += atlas->pitch;
+		to += framebuffer->width;
+	}
+}
+
+/* Commands are drawn in submission order, state sorting does not pay off without a driver behind. */
+void F1Race_Framebuffer_Submit(F1RACE_FRAMEBUFFER *framebuffer, const F1RACE_DRAW_LIST *list,
+		const F1RACE_FRAMEBUFFER_ATLAS *atlas) {
+	const F1RACE_DRAW_COMMAND *command;
+	uint32_t index;
+	for (index = 0; index < list->count; index++) {
+		command = &list->commands[index];
+		if (command->kind == F1RACE_DRAW_FILL)
+			F1Race_Framebuffer_Fill(framebuffer, &command->rect, command->color);
+		else
+			F1Race_Framebuffer_Blit(framebuffer, atlas, command->image, command->rect.x, command->rect.y);
+	}
+}
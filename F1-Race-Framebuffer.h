@@ -0,0 +1,55 @@
+/*
+ * About:
+ *   Software renderer of the "F1 Race" game: rasterizes draw command lists into a CPU-side RGBA8888 buffer.
+ *
+ * License:
+ *   MIT
+ */
+
+#ifndef F1_RACE_FRAMEBUFFER_H
+#define F1_RACE_FRAMEBUFFER_H
+
+#include "F1-Race-Draw.h"
+
+/* Row kernels of the colour-keyed sprite blit, pixels with zero alpha are transparent and others are opaque. */
+typedef enum F1RACE_FRAMEBUFFER_KERNELS {
+	F1RACE_FRAMEBUFFER_KERNEL_SCALAR,
+	F1RACE_FRAMEBUFFER_KERNEL_SSE2,
+	F1RACE_FRAMEBUFFER_KERNEL_AVX2,
+	F1RACE_FRAMEBUFFER_KERNEL_WASM_SIMD,
+	F1RACE_FRAMEBUFFER_KERNEL_COUNT
+} F1RACE_FRAMEBUFFER_KERNEL;
+
+typedef void (*F1RACE_FRAMEBUFFER_ROW_KERNEL)(uint32_t *to, const uint32_t *from, int32_t count);
+
+/* Pixels are 0xRRGGBBAA words, the same layout as F1RACE_DRAW_RGB() and SDL_PIXELFORMAT_RGBA8888. */
+typedef struct {
+	uint32_t *pixels;
+	int16_t width;
+	int16_t height;
+	F1RACE_DRAW_RECT clip;
+	F1RACE_FRAMEBUFFER_KERNEL kernel;
+	F1RACE_FRAMEBUFFER_ROW_KERNEL blit_row;
+} F1RACE_FRAMEBUFFER;
+
+/* Sprite source, pitch is in pixels and rects are indexed by the image number of sprite commands. */
+typedef struct {
+	const uint32_t *pixels;
+	int32_t pitch;
+	const F1RACE_DRAW_RECT *rects;
+} F1RACE_FRAMEBUFFER_ATLAS;
+
+int F1Race_Framebuffer_Kernel_Available(F1RACE_FRAMEBUFFER_KERNEL kernel);
+const char *F1Race_Framebuffer_Kernel_Name(F1RACE_FRAMEBUFFER_KERNEL kernel);
+int F1Race_Framebuffer_Set_Kernel(F1RACE_FRAMEBUFFER *framebuffer, F1RACE_FRAMEBUFFER_KERNEL kernel);
+
+void F1Race_Framebuffer_Init(F1RACE_FRAMEBUFFER *framebuffer, uint32_t *pixels, int16_t width, int16_t height);
+void F1Race_Framebuffer_Clip(F1RACE_FRAMEBUFFER *framebuffer, const F1RACE_DRAW_RECT *clip);
+void F1Race_Framebuffer_Clear(F1RACE_FRAMEBUFFER *framebuffer, uint32_t color);
+void F1Race_Framebuffer_Fill(F1RACE_FRAMEBUFFER *framebuffer, const F1RACE_DRAW_RECT *rect, uint32_t color);
+void F1Race_Framebuffer_Blit(F1RACE_FRAMEBUFFER *framebuffer, const F1RACE_FRAMEBUFFER_ATLAS *atlas,
+	uint16_t image, int16_t x, int16_t y);
+void F1Race_Framebuffer_Submit(F1RACE_FRAMEBUFFER *framebuffer, const F1RACE_DRAW_LIST *list,
+	const F1RACE_FRAMEBUFFER_ATLAS *atlas);
+
+#endif /* F1_RACE_FRAMEBUFFER_H */
@@ -0,0 +1,130 @@
+/*
+ * About:
+ *   Pre-decoded asset packs of the "F1 Race" game: one indexed file which is memory-mapped and used in place.
+ *
+ * License:
+ *   MIT
+ */
+
+#include "F1-Race-Pack.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static uint32_t F1Race_Pack_Align(uint32_t offset) {
+	return (offset + F1RACE_PACK_ALIGNMENT - 1) & ~(uint32_t) (F1RACE_PACK_ALIGNMENT - 1);
+}
+
+/* Assigns offsets of entries with data and writes the pack, SPRITE entries have no data of their own. */
+int F1Race_Pack_Write(const char *path, F1RACE_PACK_ENTRY *entries, const void *const *data, uint32_t count) {
+	static const uint8_t padding[F1RACE_PACK_ALIGNMENT] = { 0 };
+	F1RACE_PACK_HEADER header;
+	uint32_t offset = sizeof(F1RACE_PACK_HEADER) + count * sizeof(F1RACE_PACK_ENTRY);
+	uint32_t index;
+	FILE *file;
+
+	for (index = 0; index < count; index++) {
+		if (entries[index].size == 0)
+			continue;
+		offset = F1Race_Pack_Align(offset);
+		entries[index].offset = offset;
+		offset += entries[index].size;
+	}
+
+	memcpy(header.magic, "F1PK", 4);
+	header.version = F1RACE_PACK_VERSION;
+	header.count = count;
+	header.size = offset;
+
+	file = fopen(path, "wb");
+	if (file == NULL)
+		return 0;
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(entries, sizeof(F1RACE_PACK_ENTRY), count, file);
+	offset = sizeof(F1RACE_PACK_HEADER) + count * sizeof(F1RACE_PACK_ENTRY);
+	for (index = 0; index < count; index++) {
+		if (entries[index].size == 0)
+			continue;
+		fwrite(padding, 1, entries[index].offset - offset, file);
+		fwrite(data[index], 1, entries[index].size, file);
+		offset = entries[index].offset + entries[index].size;
+	}
+	return fclose(file) == 0;
+}
+
+/*
+ * Checks the header, that every entry lies inside the data and every sprite inside the atlas, nothing is
+ * copied or decoded.
+ */
+int F1Race_Pack_Open(F1RACE_PACK *pack, const void *data, size_t size) {
+	const F1RACE_PACK_HEADER *header = (const F1RACE_PACK_HEADER *) data;
+	const F1RACE_PACK_ENTRY *entry, *atlas;
+	uint32_t index;
+
+	if (size < sizeof(F1RACE_PACK_HEADER) || memcmp(header->magic, "F1PK", 4) != 0 ||
+			header->version != F1RACE_PACK_VERSION || header->size != size || header->count > F1RACE_PACK_MAX_ENTRIES ||
+			sizeof(F1RACE_PACK_HEADER) + header->count * sizeof(F1RACE_PACK_ENTRY) > size)
+		return 0;
+
+	pack->data = (const uint8_t *) data;
+	pack->entries = (const F1RACE_PACK_ENTRY *) (header + 1);
+	pack->count = header->count;
+	for (index = 0; index < pack->count; index++) {
+		entry = &pack->entries[index];
+		if (entry->name[F1RACE_PACK_NAME_LENGTH - 1] != '\0' || entry->offset > size || entry->size > size - entry->offset)
+			return 0;
+	}
+	atlas = F1Race_Pack_Find(pack, F1RACE_PACK_ATLAS, F1RACE_PACK_PIXELS);
+	for (index = 0; index < pack->count; index++) {
+		entry = &pack->entries[index];
+		if (entry->kind == F1RACE_PACK_SPRITE && (atlas == NULL || entry->rect.x < 0 || entry->rect.y < 0 ||
+				entry->rect.w < 0 || entry->rect.h < 0 || entry->rect.x + entry->rect.w > atlas->rect.w ||
+				entry->rect.y + entry->rect.h > atlas->rect.h))
+			return 0;
+	}
+	return 1;
+}
+
+const F1RACE_PACK_ENTRY *F1Race_Pack_Find(const F1RACE_PACK *pack, const char *name, F1RACE_PACK_KIND kind) {
+	uint32_t index;
+	for (index = 0; index < pack->count; index++)
+		if (pack->entries[index].kind == (uint32_t) kind && !strcmp(pack->entries[index].name, name))
+			return &pack->entries[index];
+	return NULL;
+}
+
+const void *F1Race_Pack_Data(const F1RACE_PACK *pack, const F1RACE_PACK_ENTRY *entry) {
+	return pack->data + entry->offset;
+}
+
+/* Places rects on shelves sorted by height and returns the atlas height, empty rects are left in place. */
+int16_t F1Race_Pack_Atlas(F1RACE_DRAW_RECT *rects, uint32_t count, int16_t width, int16_t padding) {
+	uint32_t order[F1RACE_PACK_MAX_ENTRIES];
+	uint32_t used = 0, index, j, swap;
+	int16_t x = 0, y = 0, shelf = 0;
+
+	for (index = 0; index < count && used < F1RACE_PACK_MAX_ENTRIES; index++)
+		if (rects[index].w > 0 && rects[index].h > 0)
+			order[used++] = index;
+	for (index = 1; index < used; index++)
+		for (j = index; j > 0 && rects[order[j]].h > rects[order[j - 1]].h; j--) {
+			swap = order[j];
+			order[j] = order[j - 1];
+			order[j - 1] = swap;
+		}
+
+	for (index = 0; index < used; index++) {
+		F1RACE_DRAW_RECT *rect = &rects[order[index]];
+		if (x + rect->w > width) {
+			x = 0;
+			y += shelf + padding;
+			shelf = 0;
+		}
+		rect->x = x;
+		rect->y = y;
+		x += rect->w + padding;
+		if (rect->h > shelf)
+			shelf = rect->h;
+	}
+	return y + shelf;
+}
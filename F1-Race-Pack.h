@@ -0,0 +1,69 @@
+/*
+ * About:
+ *   Pre-decoded asset packs of the "F1 Race" game: one indexed file which is memory-mapped and used in place.
+ *
+ * Format:
+ *   Header, entry table, then entry data aligned to F1RACE_PACK_ALIGNMENT bytes, all in host byte order.
+ *   PIXELS entries hold RGBA8888 words with a pitch of the entry width, SPRITE entries are rects inside the
+ *   PIXELS entry named F1RACE_PACK_ATLAS, PCM entries are samples ready for the mixer and FILE entries are
+ *   assets stored as is.
+ *
+ * License:
+ *   MIT
+ */
+
+#ifndef F1_RACE_PACK_H
+#define F1_RACE_PACK_H
+
+#include "F1-Race-Draw.h"
+
+#include <stddef.h>
+
+#define F1RACE_PACK_VERSION                            (1)
+#define F1RACE_PACK_ALIGNMENT                          (64)
+#define F1RACE_PACK_MAX_ENTRIES                        (64)
+#define F1RACE_PACK_NAME_LENGTH                        (48)
+#define F1RACE_PACK_ATLAS                              "atlas"
+
+typedef enum F1RACE_PACK_KINDS {
+	F1RACE_PACK_PIXELS,
+	F1RACE_PACK_SPRITE,
+	F1RACE_PACK_PCM,
+	F1RACE_PACK_FILE
+} F1RACE_PACK_KIND;
+
+typedef struct {
+	char magic[4];
+	uint32_t version;
+	uint32_t count;
+	uint32_t size;
+} F1RACE_PACK_HEADER;
+
+/* Format is the SDL pixel format of PIXELS entries and the SDL audio format of PCM entries. */
+typedef struct {
+	char name[F1RACE_PACK_NAME_LENGTH];
+	uint32_t kind;
+	uint32_t offset;
+	uint32_t size;
+	F1RACE_DRAW_RECT rect;
+	uint32_t format;
+	uint32_t frequency;
+	uint16_t channels;
+	uint16_t reserved;
+} F1RACE_PACK_ENTRY;
+
+typedef struct {
+	const uint8_t *data;
+	const F1RACE_PACK_ENTRY *entries;
+	uint32_t count;
+} F1RACE_PACK;
+
+int F1Race_Pack_Write(const char *path, F1RACE_PACK_ENTRY *entries, const void *const *data, uint32_t count);
+
+int F1Race_Pack_Open(F1RACE_PACK *pack, const void *data, size_t size);
+const F1RACE_PACK_ENTRY *F1Race_Pack_Find(const F1RACE_PACK *pack, const char *name, F1RACE_PACK_KIND kind);
+const void *F1Race_Pack_Data(const F1RACE_PACK *pack, const F1RACE_PACK_ENTRY *entry);
+
+int16_t F1Race_Pack_Atlas(F1RACE_DRAW_RECT *rects, uint32_t count, int16_t width, int16_t padding);
+
+#endif /* F1_RACE_PACK_H */
@@ -0,0 +1,244 @@
+/*
+ * About:
+ *   Offline packer of the "F1 Race" game assets: decodes bitmaps into one RGBA8888 atlas and optionally music
+ *   into PCM samples of the game mixer format, then writes them into a single pack file.
+ *
+ * License:
+ *   MIT
+ *
+ * Compile commands:
+ *   $ gcc -O2 F1-Race-Packer.c F1-Race-Pack.c -o f1race-packer -lSDL2 -lSDL2_mixer
+ *   $ ./f1race-packer --output F1-Race.pack --pcm assets/GAME_F1RACE_*
+ */
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+
+#include "F1-Race-Pack.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Same format as Mix_OpenAudio() of the game, other formats are ignored by the game. */
+#define PACKER_PCM_FREQUENCY                           (44100)
+#define PACKER_PCM_FORMAT                              (AUDIO_S16SYS)
+#define PACKER_PCM_CHANNELS                            (1)
+#define PACKER_ATLAS_WIDTH                             (128)
+#define PACKER_ATLAS_PADDING                           (1)
+
+typedef struct {
+	const char *output;
+	SDL_bool pcm;
+} PACKER_OPTIONS;
+
+static PACKER_OPTIONS options;
+
+static F1RACE_PACK_ENTRY entries[F1RACE_PACK_MAX_ENTRIES];
+static const void *entry_data[F1RACE_PACK_MAX_ENTRIES];
+static SDL_Surface *bitmaps[F1RACE_PACK_MAX_ENTRIES];
+static Mix_Chunk *chunks[F1RACE_PACK_MAX_ENTRIES];
+static void *files[F1RACE_PACK_MAX_ENTRIES];
+static uint32_t entry_count = 0;
+
+static F1RACE_PACK_ENTRY *Packer_Add(const char *name, F1RACE_PACK_KIND kind) {
+	F1RACE_PACK_ENTRY *entry;
+	if (entry_count >= F1RACE_PACK_MAX_ENTRIES || strlen(name) >= F1RACE_PACK_NAME_LENGTH) {
+		fprintf(stderr, "Packer Error: cannot add \"%s\".\n", name);
+		return NULL;
+	}
+	entry = &entries[entry_count++];
+	SDL_zerop(entry);
+	strcpy(entry->name, name);
+	entry->kind = kind;
+	return entry;
+}
+
+static SDL_bool Packer_Is_Bitmap(const char *path) {
+	size_t length = strlen(path);
+	return (length > 4 && !SDL_strcasecmp(path + length - 4, ".bmp")) ? SDL_TRUE : SDL_FALSE;
+}
+
+static SDL_bool Packer_Add_Bitmap(const char *path) {
+	SDL_Surface *bitmap = SDL_LoadBMP(path);
+	F1RACE_PACK_ENTRY *entry;
+	if (bitmap == NULL) {
+		fprintf(stderr, "SDL_LoadBMP Error: %s.\n", SDL_GetError());
+		return SDL_FALSE;
+	}
+	if ((entry = Packer_Add(path, F1RACE_PACK_SPRITE)) == NULL) {
+		SDL_FreeSurface(bitmap);
+		return SDL_FALSE;
+	}
+	bitmaps[entry_count - 1] = SDL_ConvertSurfaceFormat(bitmap, SDL_PIXELFORMAT_RGBA8888, 0);
+	SDL_FreeSurface(bitmap);
+	if (bitmaps[entry_count - 1] == NULL)
+		return SDL_FALSE;
+	entry->rect.w = bitmaps[entry_count - 1]->w;
+	entry->rect.h = bitmaps[entry_count - 1]->h;
+	return SDL_TRUE;
+}
+
+static SDL_bool Packer_Add_PCM(const char *path) {
+	Mix_Chunk *chunk = Mix_LoadWAV(path);
+	F1RACE_PACK_ENTRY *entry;
+	if (chunk == NULL) {
+		fprintf(stderr, "Mix_LoadWAV Error: %s.\n", Mix_GetError());
+		return SDL_FALSE;
+	}
+	if ((entry = Packer_Add(path, F1RACE_PACK_PCM)) == NULL) {
+		Mix_FreeChunk(chunk);
+		return SDL_FALSE;
+	}
+	chunks[entry_count - 1] = chunk;
+	entry_data[entry_count - 1] = chunk->abuf;
+	entry->size = chunk->alen;
+	entry->format = PACKER_PCM_FORMAT;
+	entry->frequency = PACKER_PCM_FREQUENCY;
+	entry->channels = PACKER_PCM_CHANNELS;
+	return SDL_TRUE;
+}
+
+static SDL_bool Packer_Add_File(const char *path) {
+	size_t size;
+	void *data = SDL_LoadFile(path, &size);
+	F1RACE_PACK_ENTRY *entry;
+	if (data == NULL) {
+		fprintf(stderr, "SDL_LoadFile Error: %s.\n", SDL_GetError());
+		return SDL_FALSE;
+	}
+	if ((entry = Packer_Add(path, F1RACE_PACK_FILE)) == NULL) {
+		SDL_free(data);
+		return SDL_FALSE;
+	}
+	files[entry_count - 1] = data;
+	entry_data[entry_count - 1] = data;
+	entry->size = (uint32_t) size;
+	return SDL_TRUE;
+}
+
+/* Sprites keep their rects in the entry table, the atlas pixels are blitted as is including the alpha channel. */
+static SDL_Surface *Packer_Build_Atlas(void) {
+	F1RACE_DRAW_RECT rects[F1RACE_PACK_MAX_ENTRIES];
+	SDL_Surface *atlas;
+	SDL_Rect target;
+	int16_t height;
+	uint32_t index;
+	F1RACE_PACK_ENTRY *entry;
+
+	for (index = 0; index < entry_count; index++)
+		rects[index] = entries[index].rect;
+	height = F1Race_Pack_Atlas(rects, entry_count, PACKER_ATLAS_WIDTH, PACKER_ATLAS_PADDING);
+	if (height == 0) {
+		fprintf(stderr, "Packer Error: no bitmaps to pack.\n");
+		return NULL;
+	}
+	if ((entry = Packer_Add(F1RACE_PACK_ATLAS, F1RACE_PACK_PIXELS)) == NULL)
+		return NULL;
+
+	atlas = SDL_CreateRGBSurfaceWithFormat(0, PACKER_ATLAS_WIDTH, height, 32, SDL_PIXELFORMAT_RGBA8888);
+	if (atlas == NULL) {
+		fprintf(stderr, "SDL_CreateRGBSurfaceWithFormat Error: %s.\n", SDL_GetError());
+		return NULL;
+	}
+	for (index = 0; index < entry_count - 1; index++)
+		if (bitmaps[index]) {
+			entries[index].rect = rects[index];
+			target.x = rects[index].x;
+			target.y = rects[index].y;
+			SDL_SetSurfaceBlendMode(bitmaps[index], SDL_BLENDMODE_NONE);
+			SDL_BlitSurface(bitmaps[index], NULL, atlas, &target);
+		}
+
+	/* Rows are stored without the surface pitch padding. */
+	if (atlas->pitch != atlas->w * 4) {
+		fprintf(stderr, "Packer Error: unexpected atlas pitch %d.\n", atlas->pitch);
+		SDL_FreeSurface(atlas);
+		return NULL;
+	}
+	entry->rect.w = atlas->w;
+	entry->rect.h = atlas->h;
+	entry->size = atlas->pitch * atlas->h;
+	entry->format = SDL_PIXELFORMAT_RGBA8888;
+	entry_data[entry_count - 1] = atlas->pixels;
+	return atlas;
+}
+
+static void Packer_Usage(const char *program) {
+	fprintf(stderr,
+		"Usage: %s [options] FILE...\n"
+		"  -o, --output FILE    pack file to write (default: F1-Race.pack)\n"
+		"  -p, --pcm            store decoded PCM samples of music instead of compressed files\n"
+		"Bitmaps go into the atlas, names of entries are the paths as given, e.g. \"assets/GAME_F1RACE_LOGO.bmp\".\n",
+		program);
+}
+
+int main(int argc, char *argv[]) {
+	SDL_Surface *atlas = NULL;
+	SDL_bool success = SDL_TRUE;
+	int first = argc, index;
+	uint32_t entry;
+
+	options.output = "F1-Race.pack";
+	for (index = 1; index < argc && first == argc; index++) {
+		if ((!strcmp(argv[index], "-o") || !strcmp(argv[index], "--output")) && index + 1 < argc)
+			options.output = argv[++index];
+		else if (!strcmp(argv[index], "-p") || !strcmp(argv[index], "--pcm"))
+			options.pcm = SDL_TRUE;
+		else if (argv[index][0] == '-') {
+			Packer_Usage(argv[0]);
+			return EXIT_FAILURE;
+		} else
+			first = index;
+	}
+	if (first == argc) {
+		Packer_Usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	/* Music is decoded by the mixer itself, no sound is played. */
+	SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+	if (SDL_Init(SDL_INIT_AUDIO) != 0) {
+		fprintf(stderr, "SDL_Init Error: %s.\n", SDL_GetError());
+		return EXIT_FAILURE;
+	}
+	if (options.pcm && (Mix_Init(MIX_INIT_OGG) != MIX_INIT_OGG ||
+			Mix_OpenAudio(PACKER_PCM_FREQUENCY, PACKER_PCM_FORMAT, PACKER_PCM_CHANNELS, 4096) == -1)) {
+		fprintf(stderr, "Mix_OpenAudio Error: %s.\n", Mix_GetError());
+		SDL_Quit();
+		return EXIT_FAILURE;
+	}
+
+	for (index = first; index < argc && success; index++) {
+		if (Packer_Is_Bitmap(argv[index]))
+			success = Packer_Add_Bitmap(argv[index]);
+		else if (options.pcm)
+			success = Packer_Add_PCM(argv[index]);
+		else
+			success = Packer_Add_File(argv[index]);
+	}
+	if (success && (atlas = Packer_Build_Atlas()) == NULL)
+		success = SDL_FALSE;
+	if (success && !F1Race_Pack_Write(options.output, entries, entry_data, entry_count)) {
+		fprintf(stderr, "Packer Error: cannot write \"%s\".\n", options.output);
+		success = SDL_FALSE;
+	}
+	if (success)
+		fprintf(stderr, "Packed %u entries into \"%s\", atlas %dx%d.\n", entry_count, options.output,
+			atlas->w, atlas->h);
+
+	for (entry = 0; entry < F1RACE_PACK_MAX_ENTRIES; entry++) {
+		if (bitmaps[entry])
+			SDL_FreeSurface(bitmaps[entry]);
+		if (chunks[entry])
+			Mix_FreeChunk(chunks[entry]);
+		if (files[entry])
+			SDL_free(files[entry]);
+	}
+	if (atlas)
+		SDL_FreeSurface(atlas);
+	if (options.pcm)
+		Mix_CloseAudio();
+	SDL_Quit();
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,115 @@
+/*
+ * About:
+ *   Compact input replays for the "F1 Race" game core: seed plus delta/varint encoded input changes per tick.
+ *
+ * License:
+ *   MIT
+ */
+
+#include "F1-Race-Replay.h"
+
+#include <string.h>
+
+#define F1RACE_REPLAY_INPUT_MASK                       (0x1F)
+#define F1RACE_REPLAY_END_FLAG                         (0x20)
+#define F1RACE_REPLAY_DELTA_SHIFT                      (6)
+
+static void F1Race_Replay_Write_Varint(FILE *file, uint64_t value) {
+	uint8_t buffer[10];
+	int length = 0;
+	while (value >= 0x80) {
+		buffer[length++] = (uint8_t) (value | 0x80);
+		value >>= 7;
+	}
+	buffer[length++] = (uint8_t) value;
+	fwrite(buffer, 1, length, file);
+}
+
+static int F1Race_Replay_Read_Varint(F1RACE_REPLAY *replay, uint64_t *value) {
+	uint64_t result = 0;
+	int shift = 0;
+	while (replay->cursor < replay->end && shift < 64) {
+		uint8_t byte = *replay->cursor++;
+		result |= (uint64_t) (byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			*value = result;
+			return 1;
+		}
+		shift += 7;
+	}
+	return 0;
+}
+
+int F1Race_Replay_Record_Open(F1RACE_REPLAY_RECORDER *recorder, const char *path, uint64_t seed) {
+	recorder->file = fopen(path, "wb");
+	if (recorder->file == NULL)
+		return 0;
+	recorder->tick = 0;
+	recorder->last_tick = 0;
+	recorder->last_input = 0;
+	fwrite("F1RP", 1, 4, recorder->file);
+	fputc(F1RACE_REPLAY_VERSION, recorder->file);
+	F1Race_Replay_Write_Varint(recorder->file, seed);
+	return 1;
+}
+
+void F1Race_Replay_Record_Tick(F1RACE_REPLAY_RECORDER *recorder, uint8_t input) {
+	input &= F1RACE_REPLAY_INPUT_MASK;
+	if (input != recorder->last_input) {
+		F1Race_Replay_Write_Varint(recorder->file,
+			((uint64_t) (recorder->tick - recorder->last_tick) << F1RACE_REPLAY_DELTA_SHIFT) | input);
+		recorder->last_tick = recorder->tick;
+		recorder->last_input = input;
+	}
+	recorder->tick++;
+}
+
+void F1Race_Replay_Record_Close(F1RACE_REPLAY_RECORDER *recorder) {
+	if (recorder->file == NULL)
+		return;
+	F1Race_Replay_Write_Varint(recorder->file,
+		((uint64_t) (recorder->tick - recorder->last_tick) << F1RACE_REPLAY_DELTA_SHIFT) | F1RACE_REPLAY_END_FLAG);
+	fclose(recorder->file);
+	recorder->file = NULL;
+}
+
+static void F1Race_Replay_Read_Change(F1RACE_REPLAY *replay) {
+	uint64_t value;
+	if (!F1Race_Replay_Read_Varint(replay, &value)) {
+		replay->next_tick = replay->tick;
+		replay->next_input = F1RACE_REPLAY_END_FLAG;
+		return;
+	}
+	replay->next_tick += (uint32_t) (value >> F1RACE_REPLAY_DELTA_SHIFT);
+	replay->next_input = (uint8_t) (value & (F1RACE_REPLAY_INPUT_MASK | F1RACE_REPLAY_END_FLAG));
+}
+
+int F1Race_Replay_Open(F1RACE_REPLAY *replay, const void *data, size_t size) {
+	const uint8_t *bytes = data;
+	if (size < 6 || memcmp(bytes, "F1RP", 4) != 0 || bytes[4] != F1RACE_REPLAY_VERSION)
+		return 0;
+	replay->cursor = bytes + 5;
+	replay->end = bytes + size;
+	if (!F1Race_Replay_Read_Varint(replay, &replay->seed))
+		return 0;
+	replay->tick = 0;
+	replay->next_tick = 0;
+	replay->input = 0;
+	replay->finished = 0;
+	F1Race_Replay_Read_Change(replay);
+	return 1;
+}
+
+int F1Race_Replay_Next(F1RACE_REPLAY *replay, uint8_t *input) {
+	while (replay->tick == replay->next_tick) {
+		if (replay->next_input & F1RACE_REPLAY_END_FLAG) {
+			replay->finished = 1;
+			return 0;
+		}
+		replay->input = replay->next_input;
+		F1Race_Replay_Read_Change(replay);
+	}
+	replay->tick++;
+	*input = replay->input;
+	return 1;
+}
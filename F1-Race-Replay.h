@@ -0,0 +1,48 @@
+/*
+ * About:
+ *   Compact input replays for the "F1 Race" game core: seed plus delta/varint encoded input changes per tick.
+ *
+ * Format:
+ *   "F1RP", version byte, varint seed, then one varint per input change: (ticks since previous change << 6) | (end << 5) | input.
+ *   The record with the end bit set marks the tick count of the whole replay and carries no input.
+ *
+ * License:
+ *   MIT
+ */
+
+#ifndef F1_RACE_REPLAY_H
+#define F1_RACE_REPLAY_H
+
+#include "F1-Race-Core.h"
+
+#include <stddef.h>
+#include <stdio.h>
+
+#define F1RACE_REPLAY_VERSION                          (2)
+
+typedef struct {
+	FILE *file;
+	uint32_t tick;
+	uint32_t last_tick;
+	uint8_t last_input;
+} F1RACE_REPLAY_RECORDER;
+
+typedef struct {
+	const uint8_t *cursor;
+	const uint8_t *end;
+	uint64_t seed;
+	uint32_t tick;
+	uint32_t next_tick;
+	uint8_t input;
+	uint8_t next_input;
+	uint8_t finished;
+} F1RACE_REPLAY;
+
+int F1Race_Replay_Record_Open(F1RACE_REPLAY_RECORDER *recorder, const char *path, uint64_t seed);
+void F1Race_Replay_Record_Tick(F1RACE_REPLAY_RECORDER *recorder, uint8_t input);
+void F1Race_Replay_Record_Close(F1RACE_REPLAY_RECORDER *recorder);
+
+int F1Race_Replay_Open(F1RACE_REPLAY *replay, const void *data, size_t size);
+int F1Race_Replay_Next(F1RACE_REPLAY *replay, uint8_t *input);
+
+#endif /* F1_RACE_REPLAY_H */
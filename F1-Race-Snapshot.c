@@ -0,0 +1,122 @@
+/*
+ * About:
+ *   Full game state snapshots of the "F1 Race" game core: a rewind ring of per-tick states and state files.
+ *
+ * License:
+ *   MIT
+ */
+
+#include "F1-Race-Snapshot.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define F1RACE_SNAPSHOT_FNV_BASIS                      (2166136261u)
+#define F1RACE_SNAPSHOT_FNV_PRIME                      (16777619u)
+
+void F1Race_Rewind_Init(F1RACE_REWIND *rewind, F1RACE_STATE *states, uint32_t capacity) {
+	rewind->states = states;
+	rewind->capacity = capacity;
+	rewind->count = 0;
+	rewind->next = 0;
+}
+
+/* Overwrites the oldest state when the ring is full. */
+void F1Race_Rewind_Push(F1RACE_REWIND *rewind, const F1RACE_STATE *state) {
+	memcpy(&rewind->states[rewind->next], state, sizeof(F1RACE_STATE));
+	rewind->next = (rewind->next + 1 == rewind->capacity) ? 0 : rewind->next + 1;
+	if (rewind->count < rewind->capacity)
+		rewind->count++;
+}
+
+/* State pushed "back" pushes before the newest one, NULL if the ring does not hold it. */
+const F1RACE_STATE *F1Race_Rewind_Peek(const F1RACE_REWIND *rewind, uint32_t back) {
+	uint32_t index;
+	if (back >= rewind->count)
+		return NULL;
+	index = (rewind->next + rewind->capacity - 1 - back) % rewind->capacity;
+	return &rewind->states[index];
+}
+
+/* Restores F1Race_Rewind_Peek() and drops it with all newer states, so the next push follows it. */
+int F1Race_Rewind_Back(F1RACE_REWIND *rewind, uint32_t back, F1RACE_STATE *state) {
+	const F1RACE_STATE *snapshot = F1Race_Rewind_Peek(rewind, back);
+	if (snapshot == NULL)
+		return 0;
+	memcpy(state, snapshot, sizeof(F1RACE_STATE));
+	rewind->count -= back + 1;
+	rewind->next = (rewind->next + rewind->capacity - (back + 1)) % rewind->capacity;
+	return 1;
+}
+
+/* FNV-1a, continued from "hash". */
+static uint32_t F1Race_Snapshot_Hash(uint32_t hash, const void *data, size_t size) {
+	const uint8_t *bytes = (const uint8_t *) data;
+	size_t index;
+	for (index = 0; index < size; index++)
+		hash = (hash ^ bytes[index]) * F1RACE_SNAPSHOT_FNV_PRIME;
+	return hash;
+}
+
+/* Compiled rulesets are cleared before they are built, so equal rules hash equally in every process. */
+uint32_t F1Race_Snapshot_Rules_Hash(const F1RACE_RULESET *ruleset) {
+	return F1Race_Snapshot_Hash(F1RACE_SNAPSHOT_FNV_BASIS, ruleset, sizeof(F1RACE_RULESET));
+}
+
+/* State bytes around the ruleset pointer, which is written as zeros, the hash covers the same bytes. */
+static uint32_t F1Race_Snapshot_State_Hash(const uint8_t *bytes) {
+	static const uint8_t zeros[sizeof(const F1RACE_RULESET *)];
+	uint32_t hash = F1Race_Snapshot_Hash(F1RACE_SNAPSHOT_FNV_BASIS, bytes, offsetof(F1RACE_STATE, ruleset));
+	hash = F1Race_Snapshot_Hash(hash, zeros, sizeof(zeros));
+	return F1Race_Snapshot_Hash(hash, bytes + offsetof(F1RACE_STATE, traffic_config),
+		sizeof(F1RACE_STATE) - offsetof(F1RACE_STATE, traffic_config));
+}
+
+int F1Race_Snapshot_Save(const F1RACE_STATE *state, const char *path) {
+	static const uint8_t zeros[sizeof(const F1RACE_RULESET *)];
+	const uint8_t *bytes = (const uint8_t *) state;
+	uint32_t words[4];
+	int result;
+	FILE *file = fopen(path, "wb");
+	if (file == NULL)
+		return 0;
+	words[0] = sizeof(F1RACE_STATE);
+	words[1] = F1RACE_OPPOSITE_CAR_COUNT;
+	words[2] = F1Race_Snapshot_Rules_Hash(state->ruleset);
+	words[3] = F1Race_Snapshot_State_Hash(bytes);
+	fwrite("F1ST", 1, 4, file);
+	fputc(F1RACE_SNAPSHOT_VERSION, file);
+	fwrite(zeros, 1, 3, file);
+	fwrite(words, sizeof(uint32_t), 4, file);
+	fwrite(bytes, 1, offsetof(F1RACE_STATE, ruleset), file);
+	fwrite(zeros, 1, sizeof(zeros), file);
+	fwrite(bytes + offsetof(F1RACE_STATE, traffic_config), 1,
+		sizeof(F1RACE_STATE) - offsetof(F1RACE_STATE, traffic_config), file);
+	result = !ferror(file);
+	return fclose(file) == 0 && result;
+}
+
+/*
+ * Loads a state saved under the same rules, "ruleset" must be compiled from them and outlive the state.
+ * The checksum only catches damaged files, so the state must also pass F1Race_State_Valid() to be played.
+ * "data" must be aligned like mapped files and malloc() blocks. The state is left unchanged on errors, the
+ * boards of a loaded one are rebuilt from its cars.
+ */
+int F1Race_Snapshot_Load(F1RACE_STATE *state, const void *data, size_t size, const F1RACE_RULESET *ruleset) {
+	const uint8_t *bytes = (const uint8_t *) data;
+	const uint8_t *saved = bytes + F1RACE_SNAPSHOT_HEADER_SIZE;
+	uint32_t words[4];
+
+	if (size != F1RACE_SNAPSHOT_HEADER_SIZE + sizeof(F1RACE_STATE) || memcmp(bytes, "F1ST", 4) != 0 ||
+		bytes[4] != F1RACE_SNAPSHOT_VERSION || ((uintptr_t) saved & (sizeof(uint64_t) - 1)) != 0)
+		return 0;
+	memcpy(words, bytes + 8, sizeof(words));
+	if (words[0] != sizeof(F1RACE_STATE) || words[1] != F1RACE_OPPOSITE_CAR_COUNT ||
+		words[2] != F1Race_Snapshot_Rules_Hash(ruleset) || words[3] != F1Race_Snapshot_State_Hash(saved) ||
+		!F1Race_State_Valid((const F1RACE_STATE *) saved))
+		return 0;
+	memcpy(state, saved, sizeof(F1RACE_STATE));
+	state->ruleset = ruleset;
+	state->bitboards_dirty = 1;
+	return 1;
+}
@@ -0,0 +1,45 @@
+/*
+ * About:
+ *   Full game state snapshots of the "F1 Race" game core: a rewind ring of per-tick states and state files.
+ *
+ * Snapshots:
+ *   F1RACE_STATE is plain data without pointers into itself, a snapshot is a copy of it and restoring is
+ *   copying it back. Copies share the compiled rules the "ruleset" field points to.
+ *
+ * Format:
+ *   "F1ST", version byte, three zero bytes, state size, traffic capacity, ruleset hash and state checksum as
+ *   native 32-bit words, then the F1RACE_STATE bytes with the ruleset pointer zeroed. Files load into builds
+ *   of the same layout only.
+ *
+ * License:
+ *   MIT
+ */
+
+#ifndef F1_RACE_SNAPSHOT_H
+#define F1_RACE_SNAPSHOT_H
+
+#include "F1-Race-Core.h"
+
+#include <stddef.h>
+
+#define F1RACE_SNAPSHOT_VERSION                        (1)
+#define F1RACE_SNAPSHOT_HEADER_SIZE                    (24) /* Keeps the state of a mapped file aligned. */
+
+/* Ring of the last "capacity" states in caller memory, newest last. */
+typedef struct {
+	F1RACE_STATE *states;
+	uint32_t capacity;
+	uint32_t count;
+	uint32_t next;
+} F1RACE_REWIND;
+
+void F1Race_Rewind_Init(F1RACE_REWIND *rewind, F1RACE_STATE *states, uint32_t capacity);
+void F1Race_Rewind_Push(F1RACE_REWIND *rewind, const F1RACE_STATE *state);
+const F1RACE_STATE *F1Race_Rewind_Peek(const F1RACE_REWIND *rewind, uint32_t back);
+int F1Race_Rewind_Back(F1RACE_REWIND *rewind, uint32_t back, F1RACE_STATE *state);
+
+uint32_t F1Race_Snapshot_Rules_Hash(const F1RACE_RULESET *ruleset);
+int F1Race_Snapshot_Save(const F1RACE_STATE *state, const char *path);
+int F1Race_Snapshot_Load(F1RACE_STATE *state, const void *data, size_t size, const F1RACE_RULESET *ruleset);
+
+#endif /* F1_RACE_SNAPSHOT_H */
@@ -0,0 +1,155 @@
+/*
+ * About:
+ *   Hot-path tracing of the "F1 Race" game: scoped timers write events into a fixed ring and per-phase
+ *   latency histograms, the ring is exported in Chrome trace-event format ("chrome://tracing", Perfetto).
+ *
+ * License:
+ *   MIT
+ */
+
+#include "F1-Race-Trace.h"
+
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+F1RACE_TRACE *f1race_trace = NULL;
+
+static const char *f1race_trace_names[F1RACE_TRACE_PHASE_COUNT] = {
+	"frame",
+	"F1Race_Cyclic_Timer",
+	"F1Race_Framemove",
+	"F1Race_CollisionCheck",
+	"F1Race_New_Opposite_Car",
+	"F1Race_Render",
+	"Render_End",
+	"SDL_RenderCopy",
+	"SDL_RenderPresent"
+};
+
+static const char *f1race_trace_categories[F1RACE_TRACE_PHASE_COUNT] = {
+	"frame", "logic", "logic", "logic", "logic", "render", "render", "present", "present"
+};
+
+uint64_t F1Race_Trace_Now(void) {
+#if defined(_WIN32)
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	if (frequency.QuadPart == 0)
+		QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (uint64_t) ((double) counter.QuadPart * 1e9 / frequency.QuadPart);
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000u + now.tv_nsec;
+#endif
+}
+
+void F1Race_Trace_Init(F1RACE_TRACE *trace) {
+	memset(trace->count, 0, sizeof(trace->count));
+	memset(trace->max, 0, sizeof(trace->max));
+	memset(trace->histogram, 0, sizeof(trace->histogram));
+	trace->head = 0;
+	trace->origin = F1Race_Trace_Now();
+}
+
+static uint32_t F1Race_Trace_Octave(uint32_t value) {
+#if defined(__GNUC__)
+	return 31 - __builtin_clz(value);
+#else
+	uint32_t octave = 0;
+	while (value >>= 1)
+		octave++;
+	return octave;
+#endif
+}
+
+/* Values below 8 get their own buckets, above that each power of two is split into eight buckets. */
+static uint32_t F1Race_Trace_Bucket(uint32_t value) {
+	uint32_t octave;
+	if (value < F1RACE_TRACE_SUB_BUCKETS)
+		return value;
+	octave = F1Race_Trace_Octave(value);
+	return (octave - 2) * F1RACE_TRACE_SUB_BUCKETS + ((value >> (octave - 3)) & (F1RACE_TRACE_SUB_BUCKETS - 1));
+}
+
+static uint32_t F1Race_Trace_Bucket_Middle(uint32_t bucket) {
+	uint32_t octave, low;
+	if (bucket < F1RACE_TRACE_SUB_BUCKETS)
+		return bucket;
+	octave = bucket / F1RACE_TRACE_SUB_BUCKETS + 2;
+	low = (F1RACE_TRACE_SUB_BUCKETS + bucket % F1RACE_TRACE_SUB_BUCKETS) << (octave - 3);
+	return low + ((1u << (octave - 3)) >> 1);
+}
+
+void F1Race_Trace_End(F1RACE_TRACE *trace, F1RACE_TRACE_PHASE phase, uint64_t start) {
+	uint64_t end = F1Race_Trace_Now();
+	uint32_t duration = (end - start > UINT32_MAX) ? UINT32_MAX : (uint32_t) (end - start);
+	F1RACE_TRACE_EVENT *event = &trace->events[trace->head & (F1RACE_TRACE_CAPACITY - 1)];
+	event->start = start - trace->origin;
+	event->duration = duration;
+	event->phase = phase;
+	trace->head++;
+	trace->count[phase]++;
+	trace->histogram[phase][F1Race_Trace_Bucket(duration)]++;
+	if (duration > trace->max[phase])
+		trace->max[phase] = duration;
+}
+
+const char *F1Race_Trace_Phase_Name(F1RACE_TRACE_PHASE phase) {
+	return (phase < F1RACE_TRACE_PHASE_COUNT) ? f1race_trace_names[phase] : "unknown";
+}
+
+/* Middle of the histogram bucket holding the percentile, in nanoseconds. */
+uint32_t F1Race_Trace_Percentile(const F1RACE_TRACE *trace, F1RACE_TRACE_PHASE phase, double percentile) {
+	uint64_t rank = (uint64_t) (percentile / 100.0 * trace->count[phase]);
+	uint64_t seen = 0;
+	uint32_t bucket;
+	if (trace->count[phase] == 0)
+		return 0;
+	if (rank >= trace->count[phase])
+		rank = trace->count[phase] - 1;
+	for (bucket = 0; bucket < F1RACE_TRACE_BUCKETS; bucket++) {
+		seen += trace->histogram[phase][bucket];
+		if (seen > rank)
+			break;
+	}
+	return F1Race_Trace_Bucket_Middle(bucket);
+}
+
+void F1Race_Trace_Report(const F1RACE_TRACE *trace, FILE *file) {
+	uint32_t phase;
+	fprintf(file, "%-24s %10s %10s %10s %10s\n", "trace phase", "count", "p50 us", "p99 us", "max us");
+	for (phase = 0; phase < F1RACE_TRACE_PHASE_COUNT; phase++) {
+		if (trace->count[phase] == 0)
+			continue;
+		fprintf(file, "%-24s %10llu %10.1f %10.1f %10.1f\n", f1race_trace_names[phase],
+			(unsigned long long) trace->count[phase],
+			F1Race_Trace_Percentile(trace, (F1RACE_TRACE_PHASE) phase, 50.0) / 1000.0,
+			F1Race_Trace_Percentile(trace, (F1RACE_TRACE_PHASE) phase, 99.0) / 1000.0,
+			trace->max[phase] / 1000.0);
+	}
+}
+
+/* Complete ("X") events of the ring from the oldest one, nested phases show up stacked in the viewer. */
+int F1Race_Trace_Write_Chrome(const F1RACE_TRACE *trace, const char *path) {
+	uint64_t index = (trace->head > F1RACE_TRACE_CAPACITY) ? trace->head - F1RACE_TRACE_CAPACITY : 0;
+	const F1RACE_TRACE_EVENT *event;
+	FILE *file = fopen(path, "w");
+	if (file == NULL)
+		return 0;
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (; index < trace->head; index++) {
+		event = &trace->events[index & (F1RACE_TRACE_CAPACITY - 1)];
+		fprintf(file, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+			f1race_trace_names[event->phase], f1race_trace_categories[event->phase],
+			event->start / 1000.0, event->duration / 1000.0, (index + 1 < trace->head) ? "," : "");
+	}
+	fprintf(file, "]}\n");
+	return fclose(file) == 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * About:
+ *   Hot-path tracing of the "F1 Race" game: scoped timers write events into a fixed ring and per-phase
+ *   latency histograms, the ring is exported in Chrome trace-event format ("chrome://tracing", Perfetto).
+ *
+ * License:
+ *   MIT
+ */
+
+#ifndef F1_RACE_TRACE_H
+#define F1_RACE_TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define F1RACE_TRACE_CAPACITY                          (1 << 16)
+#define F1RACE_TRACE_SUB_BUCKETS                       (8)
+#define F1RACE_TRACE_BUCKETS                           (30 * F1RACE_TRACE_SUB_BUCKETS)
+
+typedef enum F1RACE_TRACE_PHASES {
+	F1RACE_TRACE_FRAME,
+	F1RACE_TRACE_TICK,
+	F1RACE_TRACE_FRAMEMOVE,
+	F1RACE_TRACE_COLLISION,
+	F1RACE_TRACE_NEW_CAR,
+	F1RACE_TRACE_RENDER,
+	F1RACE_TRACE_SUBMIT,
+	F1RACE_TRACE_COPY,
+	F1RACE_TRACE_PRESENT,
+	F1RACE_TRACE_PHASE_COUNT
+} F1RACE_TRACE_PHASE;
+
+typedef struct {
+	uint64_t start;
+	uint32_t duration;
+	uint32_t phase;
+} F1RACE_TRACE_EVENT;
+
+/*
+ * Single writer, events overwrite the oldest ones once the ring is full. Times are nanoseconds since
+ * F1Race_Trace_Init(), histogram buckets are eight per power of two, so percentiles are within 1/16.
+ */
+typedef struct {
+	uint64_t origin;
+	uint64_t head;
+	uint64_t count[F1RACE_TRACE_PHASE_COUNT];
+	uint32_t max[F1RACE_TRACE_PHASE_COUNT];
+	uint32_t histogram[F1RACE_TRACE_PHASE_COUNT][F1RACE_TRACE_BUCKETS];
+	F1RACE_TRACE_EVENT events[F1RACE_TRACE_CAPACITY];
+} F1RACE_TRACE;
+
+/* Trace of the core phases, set by the front-end; the core records into it only if built with F1RACE_TRACING. */
+extern F1RACE_TRACE *f1race_trace;
+
+#if defined(F1RACE_TRACING)
+#define F1RACE_TRACE_BEGIN(scope)                      uint64_t scope = (f1race_trace != NULL) ? F1Race_Trace_Now() : 0
+#define F1RACE_TRACE_END(scope, phase)                 if (f1race_trace != NULL) F1Race_Trace_End(f1race_trace, phase, scope)
+#else
+#define F1RACE_TRACE_BEGIN(scope)
+#define F1RACE_TRACE_END(scope, phase)
+#endif
+
+uint64_t F1Race_Trace_Now(void);
+void F1Race_Trace_Init(F1RACE_TRACE *trace);
+void F1Race_Trace_End(F1RACE_TRACE *trace, F1RACE_TRACE_PHASE phase, uint64_t start);
+const char *F1Race_Trace_Phase_Name(F1RACE_TRACE_PHASE phase);
+uint32_t F1Race_Trace_Percentile(const F1RACE_TRACE *trace, F1RACE_TRACE_PHASE phase, double percentile);
+void F1Race_Trace_Report(const F1RACE_TRACE *trace, FILE *file);
+int F1Race_Trace_Write_Chrome(const F1RACE_TRACE *trace, const char *path);
+
+#endif /* F1_RACE_TRACE_H */
@@ -9,6 +9,28 @@
  *   MIT
  *
  * History:
+ *   16-Oct-2026: Added rewind of the last ticks and game state files, "--load" and "--state" options.
+ *   16-Oct-2026: Car types, spawn weights and levels are compiled into alias samplers, "--rules" option.
+ *   16-Oct-2026: Road occupancy is kept as per-lane row bitboards with lane queries for bots and tools.
+ *   16-Oct-2026: Added stress traffic with more lanes and cars kept in per-lane sorted lists, "--traffic" option.
+ *   16-Oct-2026: Opposite cars are stored as arrays per field with an occupancy bitmask.
+ *   16-Oct-2026: Test the player car against all opposite cars at once with SIMD collision kernels.
+ *   16-Oct-2026: Added renderer benchmark over video drivers, render drivers and backends, "--bench-render" option.
+ *   16-Oct-2026: Added per-tick hot-path tracing with Chrome trace export and latency histograms, "--trace" option.
+ *   16-Oct-2026: Added startup and shutdown profiler with JSON report, "--profile" option and F1RACE_PROFILE variable.
+ *   16-Oct-2026: Play crash and "Game Over" sounds as pre-decoded chunks over music, added "--audio-buffer" option.
+ *   16-Oct-2026: Open audio and load music in the background after the first frame, added "--startup-stats" option.
+ *   16-Oct-2026: Added memory-mapped pre-decoded asset packs, "--pack" option and "f1race-packer" utility.
+ *   16-Oct-2026: Added build with all assets embedded into the executable and loaded from memory.
+ *   16-Oct-2026: Added CPU-side framebuffer renderer backend, "--backend" option.
+ *   16-Oct-2026: Redraw only changed status regions and static screens once, skip presenting unchanged frames.
+ *   16-Oct-2026: Batched drawing through a state-sorted command list, added "--draw-stats" option.
+ *   16-Oct-2026: Packed all bitmaps into a single texture atlas.
+ *   16-Oct-2026: Wait on input events between deadlines, added "--latency" report, direction keys may be held together.
+ *   16-Oct-2026: Implemented fixed-timestep logic with interpolated rendering at display refresh rate.
+ *   16-Oct-2026: Added input recording and fast memory-mapped replay playback, "--record" and "--replay" options.
+ *   16-Oct-2026: Replaced rand() with a seedable per-game generator, added "--seed" option.
+ *   16-Oct-2026: Moved game logic into the headless and reentrant "F1-Race-Core.c" module.
  *   19-Sep-2022: Implemented screen resizing on Phantom Horror request.
  *   16-Sep-2022: Implemented "Game Over" screen.
  *   15-Sep-2022: Added new MIDIs, switching, and mute.
@@ -19,11 +41,12 @@
  *   13-Sep-2022: Created initial draft/demo version.
  *
  * Compile commands:
- *   $ clear && clear && gcc F1-Race.c -o F1-Race -lSDL2 -lSDL2_mixer && strip -s F1-Race && ./F1-Race
- *   $ emcc --use-preload-plugins --preload-file assets F1-Race.c -s USE_SDL=2 -s USE_SDL_MIXER=2 -o F1-Race.html
+ *   $ clear && clear && gcc -DF1RACE_TRACING F1-Race.c F1-Race-Collision.c F1-Race-Core.c F1-Race-Draw.c F1-Race-File.c F1-Race-Framebuffer.c F1-Race-Pack.c F1-Race-Replay.c F1-Race-Snapshot.c F1-Race-Trace.c -o F1-Race -lSDL2 -lSDL2_mixer && strip -s F1-Race && ./F1-Race
+ *   $ emcc -DF1RACE_TRACING --use-preload-plugins --preload-file assets F1-Race.c F1-Race-Collision.c F1-Race-Core.c F1-Race-Draw.c F1-Race-File.c F1-Race-Framebuffer.c F1-Race-Pack.c F1-Race-Replay.c F1-Race-Snapshot.c F1-Race-Trace.c -s USE_SDL=2 -s USE_SDL_MIXER=2 -o F1-Race.html
  *
- * Create header file with resources:
- *   $ rm Resources.h ; find assets/ -type f -exec xxd -i {} >> Resources.h \;
+ * Create header file with resources and embed them, see "build-linux-embedded" Makefile target:
+ *   $ rm Resources.h ; find assets/ -type f -exec sh -c 'xxd -i "$1" | sed "s/^unsigned/static const unsigned/"' sh {} \; >> Resources.h
+ *   $ gcc -DF1RACE_EMBEDDED_ASSETS F1-Race.c F1-Race-Collision.c F1-Race-Core.c F1-Race-Draw.c F1-Race-File.c F1-Race-Framebuffer.c F1-Race-Pack.c F1-Race-Replay.c F1-Race-Snapshot.c F1-Race-Trace.c -o F1-Race -lSDL2 -lSDL2_mixer
  *
  * Convert GIFs to BMPs using ImageMagick and FFmpeg utilities:
  *   $ find -name "*.gif" -exec sh -c 'ffmpeg -i "$1" `basename $1 .gif`.bmp' sh {} \;
@@ -43,8 +66,22 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_mixer.h>
 
+#include "F1-Race-Core.h"
+#include "F1-Race-Draw.h"
+#include "F1-Race-File.h"
+#include "F1-Race-Framebuffer.h"
+#include "F1-Race-Pack.h"
+#include "F1-Race-Replay.h"
+#include "F1-Race-Snapshot.h"
+#include "F1-Race-Trace.h"
+
+#if defined(F1RACE_EMBEDDED_ASSETS)
+#include "Resources.h"
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <time.h>
 
@@ -52,88 +89,115 @@
 #define WINDOW_HEIGHT                                  (256)
 #define TEXTURE_WIDTH                                  (128)
 #define TEXTURE_HEIGHT                                 (128)
+#define TEXTURE_ATLAS_WIDTH                            (128)
+#define TEXTURE_ATLAS_PADDING                          (1)
 
-#define F1RACE_PLAYER_CAR_IMAGE_SIZE_X                 (15)
-#define F1RACE_PLAYER_CAR_IMAGE_SIZE_Y                 (20)
-#define F1RACE_PLAYER_CAR_CARSH_IMAGE_SIZE_X           (15)
-#define F1RACE_PLAYER_CAR_CARSH_IMAGE_SIZE_Y           (25)
-#define F1RACE_PLAYER_CAR_FLY_IMAGE_SIZE_X             (23)
-#define F1RACE_PLAYER_CAR_FLY_IMAGE_SIZE_Y             (27)
-#define F1RACE_PLAYER_CAR_HEAD_LIGHT_IMAGE_SIZE_X      (7)
-#define F1RACE_PLAYER_CAR_HEAD_LIGHT_IMAGE_SIZE_Y      (15)
-#define F1RACE_PLAYER_CAR_HEAD_LIGHT_0_SHIFT           (1)
-#define F1RACE_PLAYER_CAR_HEAD_LIGHT_1_SHIFT           (7)
-#define F1RACE_OPPOSITE_CAR_TYPE_COUNT                 (7)
-#define F1RACE_PLAYER_CAR_FLY_FRAME_COUNT              (10)
-#define F1RACE_OPPOSITE_CAR_0_IMAGE_SIZE_X             (17)
-#define F1RACE_OPPOSITE_CAR_0_IMAGE_SIZE_Y             (35)
-#define F1RACE_OPPOSITE_CAR_1_IMAGE_SIZE_X             (12)
-#define F1RACE_OPPOSITE_CAR_1_IMAGE_SIZE_Y             (18)
-#define F1RACE_OPPOSITE_CAR_2_IMAGE_SIZE_X             (15)
-#define F1RACE_OPPOSITE_CAR_2_IMAGE_SIZE_Y             (20)
-#define F1RACE_OPPOSITE_CAR_3_IMAGE_SIZE_X             (12)
-#define F1RACE_OPPOSITE_CAR_3_IMAGE_SIZE_Y             (18)
-#define F1RACE_OPPOSITE_CAR_4_IMAGE_SIZE_X             (17)
-#define F1RACE_OPPOSITE_CAR_4_IMAGE_SIZE_Y             (27)
-#define F1RACE_OPPOSITE_CAR_5_IMAGE_SIZE_X             (13)
-#define F1RACE_OPPOSITE_CAR_5_IMAGE_SIZE_Y             (21)
-#define F1RACE_OPPOSITE_CAR_6_IMAGE_SIZE_X             (13)
-#define F1RACE_OPPOSITE_CAR_6_IMAGE_SIZE_Y             (22)
-#define F1RACE_OPPOSITE_CAR_COUNT                      (8)
-#define F1RACE_OPPOSITE_CAR_DEFAULT_APPEAR_RATE        (2)
-#define F1RACE_MAX_FLY_COUNT                           (9)
 #define F1RACE_TIMER_ELAPSE                            (100)
-#define F1RACE_PLAYER_CAR_SHIFT                        (5)
-#define F1RACE_PLAYER_CAR_FLY_SHIFT                    (2)
-#define F1RACE_DISPLAY_START_X                         (3)
-#define F1RACE_DISPLAY_START_Y                         (3)
-#define F1RACE_DISPLAY_END_X                           (124)
-#define F1RACE_DISPLAY_END_Y                           (124)
-#define F1RACE_ROAD_WIDTH                              (23)
-#define F1RACE_SEPARATOR_WIDTH                         (3)
-#define F1RACE_GRASS_WIDTH                             (7)
-#define F1RACE_STATUS_WIDTH                            (32)
-#define F1RACE_SEPARATOR_HEIGHT_SPACE                  (3)
-#define F1RACE_SEPARATOR_RATIO                         (6)
-#define F1RACE_SEPARATOR_HEIGHT                        (F1RACE_SEPARATOR_HEIGHT_SPACE*F1RACE_SEPARATOR_RATIO)
-#define F1RACE_STATUS_NUMBER_WIDTH                     (4)
-#define F1RACE_STATUS_NUBBER_HEIGHT                    (7)
-#define F1RACE_GRASS_0_START_X                         (F1RACE_DISPLAY_START_X)
-#define F1RACE_GRASS_0_END_X                           (F1RACE_GRASS_0_START_X + F1RACE_GRASS_WIDTH)-1
-#define F1RACE_ROAD_0_START_X                          (F1RACE_GRASS_0_START_X + F1RACE_GRASS_WIDTH)
-#define F1RACE_ROAD_0_END_X                            (F1RACE_ROAD_0_START_X + F1RACE_ROAD_WIDTH)-1
-#define F1RACE_SEPARATOR_0_START_X                     (F1RACE_ROAD_0_START_X + F1RACE_ROAD_WIDTH)
-#define F1RACE_SEPARATOR_0_END_X                       (F1RACE_SEPARATOR_0_START_X + F1RACE_SEPARATOR_WIDTH)-1
-#define F1RACE_ROAD_1_START_X                          (F1RACE_SEPARATOR_0_START_X + F1RACE_SEPARATOR_WIDTH)
-#define F1RACE_ROAD_1_END_X                            (F1RACE_ROAD_1_START_X + F1RACE_ROAD_WIDTH)-1
-#define F1RACE_SEPARATOR_1_START_X                     (F1RACE_ROAD_1_START_X + F1RACE_ROAD_WIDTH)
-#define F1RACE_SEPARATOR_1_END_X                       (F1RACE_SEPARATOR_1_START_X + F1RACE_SEPARATOR_WIDTH)-1
-#define F1RACE_ROAD_2_START_X                          (F1RACE_SEPARATOR_1_START_X + F1RACE_SEPARATOR_WIDTH)
-#define F1RACE_ROAD_2_END_X                            (F1RACE_ROAD_2_START_X + F1RACE_ROAD_WIDTH)-1
-#define F1RACE_GRASS_1_START_X                         (F1RACE_ROAD_2_START_X + F1RACE_ROAD_WIDTH)
-#define F1RACE_GRASS_1_END_X                           (F1RACE_GRASS_1_START_X + F1RACE_GRASS_WIDTH)-1
-#define F1RACE_STATUS_START_X                          (F1RACE_GRASS_1_START_X + F1RACE_GRASS_WIDTH)
-#define F1RACE_STATUS_END_X                            (F1RACE_STATUS_START_X + F1RACE_STATUS_WIDTH)
-
-#define F1RACE_RELEASE_ALL_KEY {                       \
-    f1race_key_up_pressed      = SDL_FALSE;            \
-    f1race_key_down_pressed    = SDL_FALSE;            \
-    f1race_key_left_pressed    = SDL_FALSE;            \
-    f1race_key_right_pressed   = SDL_FALSE;            \
-    if (f1race_is_crashing == SDL_TRUE)                \
+#define F1RACE_TICK_RATE                               (1000 / F1RACE_TIMER_ELAPSE)
+#define F1RACE_MAX_TICK_RATE                           (1000)
+#define F1RACE_MAX_TICKS_PER_FRAME                     (5)
+#define F1RACE_DEFAULT_REFRESH_RATE                    (60)
+#define F1RACE_BENCH_FRAMES_PER_TICK                   (F1RACE_DEFAULT_REFRESH_RATE / F1RACE_TICK_RATE)
+#define F1RACE_LATENCY_PENDING                         (16)
+#define F1RACE_LATENCY_SAMPLES                         (16384)
+#define F1RACE_PROFILE_SPANS                           (128)
+#define F1RACE_PACK_PATH                               "F1-Race.pack"
+#define F1RACE_STATE_PATH                              "F1-Race.state"
+#define F1RACE_REWIND_BYTES                            (1 << 20)
+#define F1RACE_REWIND_STATES                           ((F1RACE_REWIND_BYTES / sizeof(F1RACE_STATE) > 2) ? \
+                                                        F1RACE_REWIND_BYTES / sizeof(F1RACE_STATE) : 2)
+#define F1RACE_AUDIO_FREQUENCY                         (44100)
+#define F1RACE_AUDIO_BUFFER                            (1024)
+#define F1RACE_AUDIO_MIN_BUFFER                        (128)
+#define F1RACE_AUDIO_MAX_BUFFER                        (8192)
+#define MUSIC_CHANNEL                                  (0)
+#define SOUND_CHANNEL                                  (1)
+
+#define F1RACE_IGNORE_KEY_WHEN_CRASHING {              \
+    if (f1race_state.is_crashing)                      \
         return;                                        \
 }                                                      \
 
+/* Embedded assets are the "xxd -i" arrays of Resources.h, their names are the paths with "/" and "." replaced. */
+typedef struct {
+	const char *path;
+	const unsigned char *data;
+	size_t size;
+} ASSET;
+
+#if defined(F1RACE_EMBEDDED_ASSETS)
+#define ASSET_BMP(name)                                { "assets/" #name ".bmp", assets_##name##_bmp, sizeof(assets_##name##_bmp) }
+#define ASSET_OGG(name)                                { "assets/" #name ".ogg", assets_##name##_ogg, sizeof(assets_##name##_ogg) }
+#else
+#define ASSET_BMP(name)                                { "assets/" #name ".bmp", NULL, 0 }
+#define ASSET_OGG(name)                                { "assets/" #name ".ogg", NULL, 0 }
+#endif
+
+/* Memory-mapped asset pack, assets missing in it are loaded from their own files. */
+static F1RACE_FILE_MAPPING pack_mapping;
+static F1RACE_PACK pack;
+static SDL_bool pack_loaded = SDL_FALSE;
+
 typedef enum MUSIC_TRACKS {
 	MUSIC_BACKGROUND,
 	MUSIC_BACKGROUND_LOWCOST,
-	MUSIC_CRASH,
-	MUSIC_GAMEOVER,
 	MUSIC_MAX
 } MUSIC_TRACK;
 static Mix_Music *music_tracks[MUSIC_MAX] = { NULL };
+static Mix_Chunk *music_chunks[MUSIC_MAX] = { NULL }; // Pre-decoded tracks played on MUSIC_CHANNEL.
+
+/* Short effects are decoded once and played on their own channels over the music. */
+typedef enum SOUNDS {
+	SOUND_CRASH,
+	SOUND_GAMEOVER,
+	SOUND_MAX
+} SOUND;
+static Mix_Chunk *sound_chunks[SOUND_MAX] = { NULL };
 static Sint32 volume_old = -1;
 
+/* Audio device and music are loaded in the background, music requests are deferred until they are ready. */
+typedef enum AUDIO_STATES {
+	AUDIO_LOADING,
+	AUDIO_READY,
+	AUDIO_FAILED
+} AUDIO_STATE;
+
+typedef struct {
+	SDL_Thread *thread;
+	SDL_atomic_t done;
+	AUDIO_STATE state;
+	SDL_bool pending;
+	MUSIC_TRACK pending_track;
+	Sint32 pending_loop;
+	Sint32 volume;
+} AUDIO;
+static AUDIO audio = { NULL, { 0 }, AUDIO_LOADING, SDL_FALSE, MUSIC_BACKGROUND, 0, MIX_MAX_VOLUME };
+
+/* Performance counter values of startup milestones, zero until reached. */
+typedef struct {
+	Uint64 start;
+	Uint64 first_frame;
+	Uint64 audio_ready;
+} STARTUP;
+static STARTUP startup;
+
+/* Timed startup and shutdown phases, spans may come from the audio thread so they are claimed atomically. */
+typedef struct {
+	const char *name;
+	const char *asset;
+	SDL_bool audio_thread;
+	Uint64 start;
+	Uint64 end;
+} PROFILE_SPAN;
+
+typedef struct {
+	SDL_bool enabled;
+	SDL_threadID main_thread;
+	SDL_atomic_t count;
+	PROFILE_SPAN spans[F1RACE_PROFILE_SPANS];
+} PROFILE;
+static PROFILE profile;
+
 typedef enum TEXTURES {
 	TEXTURE_NUMBER_0,
 	TEXTURE_NUMBER_1,
@@ -170,163 +234,892 @@ typedef enum TEXTURES {
 	TEXTURE_MAX
 } TEXTURE;
 static SDL_Texture *textures[TEXTURE_MAX] = { NULL };
-
+static SDL_Texture *texture_atlas = NULL;
+static SDL_Rect texture_rects[TEXTURE_MAX];
+static Sint32 texture_atlas_width = 0;
+static Sint32 texture_atlas_height = 0;
+static SDL_Surface *texture_atlas_surface = NULL;
+
+typedef enum BACKENDS {
+	BACKEND_SDL,
+	BACKEND_FRAMEBUFFER
+} BACKEND;
+
+/* CPU-side screen of the framebuffer backend, uploaded to the streaming TEXTURE_SCREEN once per frame. */
+static Uint32 framebuffer_pixels[TEXTURE_WIDTH * TEXTURE_HEIGHT];
+static F1RACE_FRAMEBUFFER framebuffer;
+static F1RACE_FRAMEBUFFER_ATLAS framebuffer_atlas;
+static F1RACE_DRAW_RECT framebuffer_rects[TEXTURE_MAX];
+
+/* Draw commands of the current render target pass, flushed on clip, clear and target changes. */
+static F1RACE_DRAW_LIST draw_list;
+static Uint32 draw_color = F1RACE_DRAW_RGB(0, 0, 0);
+static Uint64 draw_submitted_state = ~0ull;
+static F1RACE_DRAW_STATS draw_frame;
+static F1RACE_DRAW_STATS draw_max;
+static Uint64 draw_total_calls = 0;
+static Uint64 draw_total_state_changes = 0;
+static Uint64 draw_total_commands = 0;
+static Uint32 draw_frames = 0;
+static Uint32 draw_skipped_frames = 0;
+
+/* Values shown by the status panel at the last redraw, -1 forces a redraw of the region. */
 typedef struct {
-	Sint16 pos_x;
-	Sint16 pos_y;
-	Sint16 dx;
-	Sint16 dy;
-	TEXTURE image;
-	TEXTURE image_fly;
-	TEXTURE image_head_light;
-} F1RACE_CAR_STRUCT;
-
-typedef struct {
-	Sint16 dx;
-	Sint16 dy;
-	Sint16 speed;
-	Sint16 dx_from_road;
-	TEXTURE image;
-} F1RACE_OPPOSITE_CAR_TYPE_STRUCT;
-
+	Sint16 score;
+	Sint16 level;
+	Sint16 fly_count;
+	Sint16 fly_charger_count;
+} STATUS;
+static STATUS status_drawn = { -1, -1, -1, -1 };
+
+/* What the road pass draws: separator offsets, the player car sprite and the cars on the screen in slot order. */
 typedef struct {
-	Sint16 dx;
-	Sint16 dy;
-	Sint16 speed;
-	Sint16 dx_from_road;
-	TEXTURE image;
-	Sint16 pos_x;
-	Sint16 pos_y;
-	Uint8 road_id;
-	SDL_bool is_empty;
-	SDL_bool is_add_score;
-} F1RACE_OPPOSITE_CAR_STRUCT;
-
-#ifdef __EMSCRIPTEN__
+	Sint16 lanes;
+	Sint16 separator_0_block_start_y;
+	Sint16 separator_1_block_start_y;
+	Sint16 player_x;
+	Sint16 player_y;
+	Sint16 player_image;
+	Sint16 cars;
+	Sint16 car_x[F1RACE_OPPOSITE_CAR_COUNT];
+	Sint16 car_y[F1RACE_OPPOSITE_CAR_COUNT];
+	Sint16 car_image[F1RACE_OPPOSITE_CAR_COUNT];
+} ROAD;
+static ROAD road_view;
+static ROAD road_drawn;
+static SDL_bool road_drawn_valid = SDL_FALSE;
+static SDL_bool render_dirty = SDL_TRUE;
+static SDL_bool render_repaint = SDL_FALSE;
+
+/* Fixed-timestep scheduler, the accumulator counts performance counter ticks multiplied by the tick rate. */
 typedef struct {
 	SDL_Texture *texture;
-} CONTEXT_EMSCRIPTEN;
-#endif
+	Uint64 frequency;
+	Uint64 counter;
+	Uint64 accumulator;
+	Uint32 refresh_rate;
+	SDL_bool vsync;
+	SDL_bool presented;
+} CONTEXT;
 
 static SDL_bool exit_main_loop = SDL_FALSE;
 static SDL_bool using_new_background_ogg = SDL_FALSE;
 static SDL_Renderer *render = NULL;
 
-static SDL_bool f1race_is_new_game = SDL_TRUE;
-static SDL_bool f1race_is_crashing = SDL_FALSE;
-static Sint16 f1race_crashing_count_down;
-static Sint16 f1race_separator_0_block_start_y;
-static Sint16 f1race_separator_1_block_start_y;
-static Sint16 f1race_last_car_road;
-static SDL_bool f1race_player_is_car_fly;
-static Sint16 f1race_player_car_fly_duration;
-static Sint16 f1race_score;
-static Sint16 f1race_level;
-static Sint16 f1race_pass;
-static Sint16 f1race_fly_count;
-static Sint16 f1race_fly_charger_count;
-
-static SDL_bool f1race_key_up_pressed = SDL_FALSE;
-static SDL_bool f1race_key_down_pressed = SDL_FALSE;
-static SDL_bool f1race_key_right_pressed = SDL_FALSE;
-static SDL_bool f1race_key_left_pressed = SDL_FALSE;
-
-static F1RACE_CAR_STRUCT f1race_player_car;
-static F1RACE_OPPOSITE_CAR_TYPE_STRUCT f1race_opposite_car_type[F1RACE_OPPOSITE_CAR_TYPE_COUNT];
-static F1RACE_OPPOSITE_CAR_STRUCT f1race_opposite_car[F1RACE_OPPOSITE_CAR_COUNT];
+static F1RACE_STATE f1race_state;
+static F1RACE_STATE f1race_state_previous;
+/*
+ * Fields of the state the render passes read, between the previous and the current tick. Cars are not
+ * copied, the road pass reads them from both states at "alpha".
+ */
+typedef struct {
+	F1RACE_CAR_STRUCT player_car;
+	Uint8 player_is_car_fly;
+	Sint16 player_car_fly_duration;
+	Sint16 separator_0_block_start_y;
+	Sint16 separator_1_block_start_y;
+	Sint16 score;
+	Sint16 level;
+	Sint16 fly_count;
+	Sint16 fly_charger_count;
+	double alpha;
+} VIEW;
+static VIEW f1race_view;
+static Uint8 f1race_input = 0;
+
+static F1RACE_REPLAY_RECORDER f1race_recorder = { NULL };
+
+/* States before the last ticks, about two minutes of the classic traffic. */
+static F1RACE_STATE f1race_rewind_states[F1RACE_REWIND_STATES];
+static F1RACE_REWIND f1race_rewind;
+static SDL_bool f1race_rewinding = SDL_FALSE;
+static SDL_bool f1race_load_pending = SDL_FALSE;
+
+/* Key-down timestamps waiting for the tick that applies them and for the present that shows them. */
+typedef struct {
+	Uint64 applying[F1RACE_LATENCY_PENDING];
+	Uint64 presenting[F1RACE_LATENCY_PENDING];
+	Uint32 applying_count;
+	Uint32 presenting_count;
+	float state_samples[F1RACE_LATENCY_SAMPLES];
+	float present_samples[F1RACE_LATENCY_SAMPLES];
+	Uint32 state_count;
+	Uint32 present_count;
+} LATENCY;
+static LATENCY latency;
+
+typedef struct {
+	Uint64 seed;
+	Uint32 tick_rate;
+	SDL_bool latency;
+	SDL_bool startup_stats;
+	Uint32 audio_buffer;
+	SDL_bool draw_stats;
+	BACKEND backend;
+	const char *record;
+	const char *replay;
+	const char *pack;
+	const char *profile;
+	const char *trace;
+	Uint32 bench_render;
+	const char *state;
+	const char *load;
+	F1RACE_TRAFFIC_CONFIG traffic;
+	const F1RACE_RULESET *rules;
+} OPTIONS;
+static OPTIONS options;
+static F1RACE_RULESET options_rules;
+
+#if defined(F1RACE_TRACING)
+static F1RACE_TRACE trace;
+#endif
+
+static int Profile_Begin(const char *name, const char *asset) {
+	int span;
+	if (!profile.enabled || (span = SDL_AtomicAdd(&profile.count, 1)) >= F1RACE_PROFILE_SPANS)
+		return -1;
+	profile.spans[span].name = name;
+	profile.spans[span].asset = asset;
+	profile.spans[span].audio_thread = (SDL_ThreadID() != profile.main_thread) ? SDL_TRUE : SDL_FALSE;
+	profile.spans[span].start = SDL_GetPerformanceCounter();
+	return span;
+}
+
+static void Profile_End(int span) {
+	if (span >= 0)
+		profile.spans[span].end = SDL_GetPerformanceCounter();
+}
+
+static void Profile_Write_Milliseconds(FILE *file, const char *key, Uint64 counter, const char *separator) {
+	if (counter == 0)
+		fprintf(file, "  \"%s\": null%s\n", key, separator);
+	else
+		fprintf(file, "  \"%s\": %.3f%s\n", key,
+			(counter - startup.start) * 1000.0 / SDL_GetPerformanceFrequency(), separator);
+}
+
+/* Times are milliseconds since the process start, "-" writes the report to the standard output. */
+static void Profile_Write(const char *path) {
+	double frequency = (double) SDL_GetPerformanceFrequency();
+	int count = SDL_AtomicGet(&profile.count), span;
+	FILE *file = strcmp(path, "-") ? fopen(path, "w") : stdout;
+	const PROFILE_SPAN *current;
+
+	if (file == NULL) {
+		fprintf(stderr, "Profile Error: cannot create \"%s\".\n", path);
+		return;
+	}
+	if (count > F1RACE_PROFILE_SPANS)
+		count = F1RACE_PROFILE_SPANS;
+	fprintf(file, "{\n");
+	Profile_Write_Milliseconds(file, "first_frame_ms", startup.first_frame, ",");
+	Profile_Write_Milliseconds(file, "audio_ready_ms", startup.audio_ready, ",");
+	fprintf(file, "  \"audio\": \"%s\",\n",
+		(audio.state == AUDIO_READY) ? "ready" : (audio.state == AUDIO_FAILED) ? "failed" : "loading");
+	fprintf(file, "  \"spans\": [\n");
+	for (span = 0; span < count; span++) {
+		current = &profile.spans[span];
+		fprintf(file, "    { \"name\": \"%s\", ", current->name);
+		if (current->asset)
+			fprintf(file, "\"asset\": \"%s\", ", current->asset);
+		fprintf(file, "\"thread\": \"%s\", \"start_ms\": %.3f, \"duration_ms\": %.3f }%s\n",
+			current->audio_thread ? "audio" : "main", (current->start - startup.start) * 1000.0 / frequency,
+			(current->end > current->start) ? (current->end - current->start) * 1000.0 / frequency : 0.0,
+			(span + 1 < count) ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+	if (file != stdout)
+		fclose(file);
+}
+
+static void Pack_Load(void) {
+	const char *path = (options.pack != NULL) ? options.pack : F1RACE_PACK_PATH;
+	if (!F1Race_File_Map(&pack_mapping, path)) {
+		if (options.pack != NULL)
+			fprintf(stderr, "Pack Error: cannot map \"%s\".\n", path);
+		return;
+	}
+	pack_loaded = F1Race_Pack_Open(&pack, pack_mapping.data, pack_mapping.size) ? SDL_TRUE : SDL_FALSE;
+	if (!pack_loaded) {
+		fprintf(stderr, "Pack Error: \"%s\" is not a valid asset pack.\n", path);
+		F1Race_File_Unmap(&pack_mapping);
+	}
+}
+
+static void Pack_Unload(void) {
+	if (pack_loaded)
+		F1Race_File_Unmap(&pack_mapping);
+	pack_loaded = SDL_FALSE;
+}
 
+static const F1RACE_PACK_ENTRY *Pack_Find(const char *name, F1RACE_PACK_KIND kind) {
+	return (pack_loaded && name != NULL) ? F1Race_Pack_Find(&pack, name, kind) : NULL;
+}
+
+/* Returns the pack atlas if it holds RGBA8888 pixels without row padding. */
+static const F1RACE_PACK_ENTRY *Pack_Atlas(void) {
+	const F1RACE_PACK_ENTRY *atlas = Pack_Find(F1RACE_PACK_ATLAS, F1RACE_PACK_PIXELS);
+	if (atlas == NULL || atlas->format != SDL_PIXELFORMAT_RGBA8888 ||
+			atlas->size != (Uint32) atlas->rect.w * atlas->rect.h * sizeof(Uint32))
+		return NULL;
+	return atlas;
+}
+
+/*
+ * Assets are read in place from the pack mapping or the executable image if they are embedded, others are
+ * opened from the "assets/" directory.
+ */
+static SDL_RWops *Asset_Open(const ASSET *asset) {
+	const F1RACE_PACK_ENTRY *entry = Pack_Find(asset->path, F1RACE_PACK_FILE);
+	SDL_RWops *stream;
+	if (entry != NULL)
+		stream = SDL_RWFromConstMem(F1Race_Pack_Data(&pack, entry), (int) entry->size);
+	else if (asset->data != NULL)
+		stream = SDL_RWFromConstMem(asset->data, (int) asset->size);
+	else
+		stream = SDL_RWFromFile(asset->path, "rb");
+	if (stream == NULL)
+		fprintf(stderr, "Asset_Open Error: %s: %s.\n", asset->path, SDL_GetError());
+	return stream;
+}
+
+/* Bitmaps of the pack are surfaces over the atlas pixels of the mapping and must not be modified. */
+static SDL_Surface *Asset_Load_Bitmap(const ASSET *asset) {
+	const F1RACE_PACK_ENTRY *sprite = Pack_Find(asset->path, F1RACE_PACK_SPRITE);
+	const F1RACE_PACK_ENTRY *atlas = (sprite != NULL) ? Pack_Atlas() : NULL;
+	SDL_RWops *stream;
+	SDL_Surface *bitmap;
+	if (atlas != NULL) {
+		const Uint32 *pixels = (const Uint32 *) F1Race_Pack_Data(&pack, atlas);
+		bitmap = SDL_CreateRGBSurfaceWithFormatFrom((void *) (pixels + sprite->rect.y * atlas->rect.w + sprite->rect.x),
+			sprite->rect.w, sprite->rect.h, 32, atlas->rect.w * sizeof(Uint32), SDL_PIXELFORMAT_RGBA8888);
+		if (bitmap == NULL)
+			fprintf(stderr, "SDL_CreateRGBSurfaceWithFormatFrom Error: %s.\n", SDL_GetError());
+		return bitmap;
+	}
+	stream = Asset_Open(asset);
+	bitmap = (stream != NULL) ? SDL_LoadBMP_RW(stream, 1) : NULL;
+	if (stream != NULL && bitmap == NULL)
+		fprintf(stderr, "SDL_LoadBMP_RW Error: %s.\n", SDL_GetError());
+	return bitmap;
+}
+
+static const ASSET music_assets[MUSIC_MAX] = {
+	ASSET_OGG(GAME_F1RACE_BGM),
+	ASSET_OGG(GAME_F1RACE_BGM_LOWCOST)
+};
+
+static const ASSET sound_assets[SOUND_MAX] = {
+	ASSET_OGG(GAME_F1RACE_CRASH),
+	ASSET_OGG(GAME_F1RACE_GAMEOVER)
+};
+
+/* Returns a chunk over the PCM samples of the pack if they are in the mixer format. */
+static Mix_Chunk *Audio_Load_Pack_Chunk(const ASSET *asset) {
+	const F1RACE_PACK_ENTRY *entry = Pack_Find(asset->path, F1RACE_PACK_PCM);
+	int frequency = 0, channels = 0;
+	Uint16 format = 0;
+	if (entry == NULL || !Mix_QuerySpec(&frequency, &format, &channels) ||
+			entry->frequency != (Uint32) frequency || entry->format != format || entry->channels != channels)
+		return NULL;
+	return Mix_QuickLoad_RAW((Uint8 *) F1Race_Pack_Data(&pack, entry), entry->size);
+}
+
+/* PCM tracks of the pack in the mixer format are played from the mapping, others are decoded while playing. */
 static void Music_Load(void) {
-	music_tracks[MUSIC_BACKGROUND] = Mix_LoadMUS("assets/GAME_F1RACE_BGM.ogg");
-	music_tracks[MUSIC_BACKGROUND_LOWCOST] = Mix_LoadMUS("assets/GAME_F1RACE_BGM_LOWCOST.ogg");
-	music_tracks[MUSIC_CRASH] = Mix_LoadMUS("assets/GAME_F1RACE_CRASH.ogg");
-	music_tracks[MUSIC_GAMEOVER] = Mix_LoadMUS("assets/GAME_F1RACE_GAMEOVER.ogg");
+	SDL_RWops *stream;
+	int i = 0;
+	int span;
+	for (; i < MUSIC_MAX; ++i) {
+		span = Profile_Begin("Music_Load_Track", music_assets[i].path);
+		if ((music_chunks[i] = Audio_Load_Pack_Chunk(&music_assets[i])) == NULL &&
+				(stream = Asset_Open(&music_assets[i])) != NULL &&
+				(music_tracks[i] = Mix_LoadMUS_RW(stream, 1)) == NULL)
+			fprintf(stderr, "Mix_LoadMUS_RW Error: %s.\n", Mix_GetError());
+		Profile_End(span);
+	}
 }
 
 static void Music_Play(MUSIC_TRACK track, Sint32 loop) {
-	Mix_PlayMusic(music_tracks[track], loop);
+	if (audio.state != AUDIO_READY) {
+		audio.pending = SDL_TRUE;
+		audio.pending_track = track;
+		audio.pending_loop = loop;
+		return;
+	}
+	if (music_chunks[track]) {
+		Mix_HaltMusic();
+		Mix_PlayChannel(MUSIC_CHANNEL, music_chunks[track], loop);
+	} else {
+		Mix_HaltChannel(MUSIC_CHANNEL);
+		Mix_PlayMusic(music_tracks[track], loop);
+	}
+}
+
+static void Music_Stop(void) {
+	audio.pending = SDL_FALSE;
+	if (audio.state != AUDIO_READY)
+		return;
+	Mix_HaltMusic();
+	Mix_HaltChannel(MUSIC_CHANNEL);
+}
+
+/* Also sets the volume of sound channels, muting silences everything like before sounds had their own channels. */
+static Sint32 Music_Volume(Sint32 volume) {
+	Sint32 volume_previous = audio.volume;
+	audio.volume = volume;
+	if (audio.state != AUDIO_READY)
+		return volume_previous;
+	Mix_Volume(-1, volume);
+	return Mix_VolumeMusic(volume);
 }
 
 static void Music_Unload(void) {
 	int i = 0;
-	for (; i < MUSIC_MAX; ++i)
+	for (; i < MUSIC_MAX; ++i) {
 		if (music_tracks[i])
 			Mix_FreeMusic(music_tracks[i]);
+		if (music_chunks[i])
+			Mix_FreeChunk(music_chunks[i]);
+	}
+}
+
+static void Sound_Load(void) {
+	SDL_RWops *stream;
+	int i = 0;
+	int span;
+	Mix_ReserveChannels(SOUND_CHANNEL + SOUND_MAX);
+	for (; i < SOUND_MAX; ++i) {
+		span = Profile_Begin("Sound_Load_Chunk", sound_assets[i].path);
+		if ((sound_chunks[i] = Audio_Load_Pack_Chunk(&sound_assets[i])) == NULL &&
+				(stream = Asset_Open(&sound_assets[i])) != NULL &&
+				(sound_chunks[i] = Mix_LoadWAV_RW(stream, 1)) == NULL)
+			fprintf(stderr, "Mix_LoadWAV_RW Error: %s.\n", Mix_GetError());
+		Profile_End(span);
+	}
+}
+
+/* Effects requested before the audio is ready are dropped, they would be out of place later. */
+static void Sound_Play(SOUND sound) {
+	if (audio.state == AUDIO_READY && sound_chunks[sound])
+		Mix_PlayChannel(SOUND_CHANNEL + sound, sound_chunks[sound], 0);
+}
+
+static void Sound_Unload(void) {
+	int i = 0;
+	for (; i < SOUND_MAX; ++i)
+		if (sound_chunks[i])
+			Mix_FreeChunk(sound_chunks[i]);
 }
 
-static void Texture_Create_Bitmap(const char *filepath, TEXTURE texture_id) {
-	SDL_Surface *bitmap = SDL_LoadBMP(filepath);
-	textures[texture_id] = SDL_CreateTextureFromSurface(render, bitmap);
-	SDL_FreeSurface(bitmap);
+/*
+ * Runs on the audio thread, or on the main loop after the first frame if there are no threads. SDL init and
+ * quit calls are not thread-safe and the audio subsystem also initializes events, which the window creation
+ * uses meanwhile, so Audio_Start() initializes it on the main thread and this only opens the mixer and loads.
+ */
+static int Audio_Load(void *data) {
+	int result = SDL_FALSE;
+	int span;
+	(void) data;
+	span = Profile_Begin("Mix_Init", NULL);
+	if (Mix_Init(MIX_INIT_OGG) != MIX_INIT_OGG)
+		fprintf(stderr, "Mix_Init Error: %s.\n", Mix_GetError());
+	else {
+		Profile_End(span);
+		span = Profile_Begin("Mix_OpenAudio", NULL);
+		result = Mix_OpenAudio(F1RACE_AUDIO_FREQUENCY, AUDIO_S16SYS, 1, options.audio_buffer) == 0;
+		if (!result)
+			fprintf(stderr, "Mix_OpenAudio Error: %s.\n", Mix_GetError());
+	}
+	Profile_End(span);
+	if (result) {
+		span = Profile_Begin("Music_Load", NULL);
+		Music_Load();
+		Profile_End(span);
+		span = Profile_Begin("Sound_Load", NULL);
+		Sound_Load();
+		Profile_End(span);
+	}
+	SDL_AtomicSet(&audio.done, 1);
+	return result;
 }
 
+static void Audio_Finish(int result) {
+	audio.thread = NULL;
+	audio.state = result ? AUDIO_READY : AUDIO_FAILED;
+	startup.audio_ready = SDL_GetPerformanceCounter();
+	if (audio.state != AUDIO_READY)
+		return;
+	if (audio.volume != MIX_MAX_VOLUME)
+		Music_Volume(audio.volume);
+	if (audio.pending)
+		Music_Play(audio.pending_track, audio.pending_loop);
+	audio.pending = SDL_FALSE;
+}
+
+static void Audio_Start(void) {
+	int span = Profile_Begin("SDL_InitSubSystem", NULL);
+	int result = SDL_InitSubSystem(SDL_INIT_AUDIO);
+	Profile_End(span);
+	if (result != 0) {
+		fprintf(stderr, "SDL_InitSubSystem Error: %s.\n", SDL_GetError());
+		Audio_Finish(SDL_FALSE);
+		return;
+	}
+#ifndef __EMSCRIPTEN__
+	audio.thread = SDL_CreateThread(Audio_Load, "F1RaceAudio", NULL);
+	if (audio.thread == NULL)
+		fprintf(stderr, "SDL_CreateThread Error: %s.\n", SDL_GetError());
+#endif
+}
+
+/* Called every frame, the game keeps running silent if the audio device cannot be opened. */
+static void Audio_Update(void) {
+	int result = SDL_FALSE;
+	if (audio.state != AUDIO_LOADING)
+		return;
+	if (audio.thread != NULL) {
+		if (!SDL_AtomicGet(&audio.done))
+			return;
+		SDL_WaitThread(audio.thread, &result);
+	} else {
+		if (startup.first_frame == 0)
+			return;
+		result = Audio_Load(NULL);
+	}
+	Audio_Finish(result);
+}
+
+static void Audio_Unload(void) {
+	int result = SDL_FALSE;
+	int span;
+	if (audio.state == AUDIO_LOADING && audio.thread != NULL) {
+		SDL_WaitThread(audio.thread, &result);
+		Audio_Finish(result);
+	}
+	if (audio.state != AUDIO_READY)
+		return;
+	span = Profile_Begin("Mix_CloseAudio", NULL);
+	Mix_CloseAudio();
+	Profile_End(span);
+	span = Profile_Begin("Music_Unload", NULL);
+	Music_Unload();
+	Profile_End(span);
+	span = Profile_Begin("Sound_Unload", NULL);
+	Sound_Unload();
+	Profile_End(span);
+}
+
+/* Sounds start mixing on the next buffer, so the buffer length bounds the event to sound latency. */
+static void Audio_Report(void) {
+	int frequency = 0, channels = 0;
+	Uint16 format = 0;
+	if (audio.state != AUDIO_READY || !Mix_QuerySpec(&frequency, &format, &channels) || frequency == 0)
+		return;
+	fprintf(stderr, "audio buffer: %u samples at %d Hz, %.1f ms\n", options.audio_buffer, frequency,
+		options.audio_buffer * 1000.0 / frequency);
+}
+
+static const ASSET texture_assets[TEXTURE_MAX] = {
+	ASSET_BMP(GAME_F1RACE_NUMBER_0),
+	ASSET_BMP(GAME_F1RACE_NUMBER_1),
+	ASSET_BMP(GAME_F1RACE_NUMBER_2),
+	ASSET_BMP(GAME_F1RACE_NUMBER_3),
+	ASSET_BMP(GAME_F1RACE_NUMBER_4),
+	ASSET_BMP(GAME_F1RACE_NUMBER_5),
+	ASSET_BMP(GAME_F1RACE_NUMBER_6),
+	ASSET_BMP(GAME_F1RACE_NUMBER_7),
+	ASSET_BMP(GAME_F1RACE_NUMBER_8),
+	ASSET_BMP(GAME_F1RACE_NUMBER_9),
+	{ NULL, NULL, 0 }, /* TEXTURE_SCREEN is a render target. */
+	ASSET_BMP(GAME_F1RACE_PLAYER_CAR),
+	ASSET_BMP(GAME_F1RACE_PLAYER_CAR_FLY),
+	ASSET_BMP(GAME_F1RACE_PLAYER_CAR_FLY_UP),
+	ASSET_BMP(GAME_F1RACE_PLAYER_CAR_FLY_DOWN),
+	ASSET_BMP(GAME_F1RACE_PLAYER_CAR_HEAD_LIGHT),
+	ASSET_BMP(GAME_F1RACE_PLAYER_CAR_CRASH),
+	ASSET_BMP(GAME_F1RACE_LOGO),
+	ASSET_BMP(GAME_F1RACE_STATUS_SCORE),
+	ASSET_BMP(GAME_F1RACE_STATUS_BOX),
+	ASSET_BMP(GAME_F1RACE_STATUS_LEVEL),
+	ASSET_BMP(GAME_F1RACE_STATUS_FLY),
+	ASSET_BMP(GAME_F1RACE_OPPOSITE_CAR_0),
+	ASSET_BMP(GAME_F1RACE_OPPOSITE_CAR_1),
+	ASSET_BMP(GAME_F1RACE_OPPOSITE_CAR_2),
+	ASSET_BMP(GAME_F1RACE_OPPOSITE_CAR_3),
+	ASSET_BMP(GAME_F1RACE_OPPOSITE_CAR_4),
+	ASSET_BMP(GAME_F1RACE_OPPOSITE_CAR_5),
+	ASSET_BMP(GAME_F1RACE_OPPOSITE_CAR_6),
+	ASSET_BMP(GAME_F1RACE_GAMEOVER),
+	ASSET_BMP(GAME_F1RACE_GAMEOVER_FIELD),
+	ASSET_BMP(GAME_F1RACE_GAMEOVER_CRASH)
+};
+
+static SDL_Surface *Texture_Load_Bitmap(const ASSET *asset) {
+	int span = Profile_Begin("Texture_Load_Bitmap", asset->path);
+	SDL_Surface *converted = NULL;
+	SDL_Surface *bitmap = Asset_Load_Bitmap(asset);
+	if (bitmap != NULL) {
+		converted = SDL_ConvertSurfaceFormat(bitmap, SDL_PIXELFORMAT_RGBA8888, 0);
+		SDL_FreeSurface(bitmap);
+	}
+	Profile_End(span);
+	return converted;
+}
+
+static void Texture_Load_Framebuffer_Atlas(const Uint32 *pixels, Sint32 pitch) {
+	int i = 0;
+	for (; i < TEXTURE_MAX; ++i) {
+		framebuffer_rects[i].x = texture_rects[i].x;
+		framebuffer_rects[i].y = texture_rects[i].y;
+		framebuffer_rects[i].w = texture_rects[i].w;
+		framebuffer_rects[i].h = texture_rects[i].h;
+	}
+	framebuffer_atlas.pixels = pixels;
+	framebuffer_atlas.pitch = pitch;
+	framebuffer_atlas.rects = framebuffer_rects;
+}
+
+/* Uploads the pack atlas straight from the mapping, falls back to bitmaps if any of them is not in the pack or the upload fails. */
+static SDL_bool Texture_Load_Pack(void) {
+	const F1RACE_PACK_ENTRY *atlas = Pack_Atlas();
+	const F1RACE_PACK_ENTRY *sprite;
+	const Uint32 *pixels;
+	int i;
+
+	if (atlas == NULL)
+		return SDL_FALSE;
+	for (i = 0; i < TEXTURE_MAX; ++i) {
+		SDL_zero(texture_rects[i]);
+		if (texture_assets[i].path == NULL)
+			continue;
+		if ((sprite = Pack_Find(texture_assets[i].path, F1RACE_PACK_SPRITE)) == NULL)
+			return SDL_FALSE;
+		texture_rects[i].x = sprite->rect.x;
+		texture_rects[i].y = sprite->rect.y;
+		texture_rects[i].w = sprite->rect.w;
+		texture_rects[i].h = sprite->rect.h;
+	}
+
+	pixels = (const Uint32 *) F1Race_Pack_Data(&pack, atlas);
+	texture_atlas_width = atlas->rect.w;
+	texture_atlas_height = atlas->rect.h;
+	if (options.backend == BACKEND_FRAMEBUFFER) {
+		Texture_Load_Framebuffer_Atlas(pixels, atlas->rect.w);
+		return SDL_TRUE;
+	}
+
+	texture_atlas = SDL_CreateTexture(render, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC,
+		atlas->rect.w, atlas->rect.h);
+	if (texture_atlas == NULL || SDL_UpdateTexture(texture_atlas, NULL, pixels, atlas->rect.w * sizeof(Uint32)) != 0) {
+		fprintf(stderr, "SDL_UpdateTexture Error: %s.\n", SDL_GetError());
+		if (texture_atlas != NULL)
+			SDL_DestroyTexture(texture_atlas);
+		texture_atlas = NULL;
+		return SDL_FALSE;
+	}
+	SDL_SetTextureBlendMode(texture_atlas, SDL_BLENDMODE_BLEND);
+	return SDL_TRUE;
+}
+
+/* Packs all bitmaps into one atlas texture on shelves sorted by height, Texture_Draw() copies sub-rects of it. */
 static void Texture_Load(void) {
-	textures[TEXTURE_SCREEN] =
-		SDL_CreateTexture(render, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, TEXTURE_WIDTH, TEXTURE_HEIGHT);
-
-	Texture_Create_Bitmap("assets/GAME_F1RACE_NUMBER_0.bmp", TEXTURE_NUMBER_0);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_NUMBER_1.bmp", TEXTURE_NUMBER_1);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_NUMBER_2.bmp", TEXTURE_NUMBER_2);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_NUMBER_3.bmp", TEXTURE_NUMBER_3);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_NUMBER_4.bmp", TEXTURE_NUMBER_4);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_NUMBER_5.bmp", TEXTURE_NUMBER_5);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_NUMBER_6.bmp", TEXTURE_NUMBER_6);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_NUMBER_7.bmp", TEXTURE_NUMBER_7);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_NUMBER_8.bmp", TEXTURE_NUMBER_8);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_NUMBER_9.bmp", TEXTURE_NUMBER_9);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_PLAYER_CAR.bmp", TEXTURE_PLAYER_CAR);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_PLAYER_CAR_FLY.bmp", TEXTURE_PLAYER_CAR_FLY);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_PLAYER_CAR_FLY_UP.bmp", TEXTURE_PLAYER_CAR_FLY_UP);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_PLAYER_CAR_FLY_DOWN.bmp", TEXTURE_PLAYER_CAR_FLY_DOWN);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_PLAYER_CAR_HEAD_LIGHT.bmp", TEXTURE_PLAYER_CAR_HEAD_LIGHT);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_PLAYER_CAR_CRASH.bmp", TEXTURE_PLAYER_CAR_CRASH);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_LOGO.bmp", TEXTURE_LOGO);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_STATUS_SCORE.bmp", TEXTURE_STATUS_SCORE);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_STATUS_BOX.bmp", TEXTURE_STATUS_BOX);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_STATUS_LEVEL.bmp", TEXTURE_STATUS_LEVEL);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_STATUS_FLY.bmp", TEXTURE_STATUS_FLY);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_OPPOSITE_CAR_0.bmp", TEXTURE_OPPOSITE_CAR_0);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_OPPOSITE_CAR_1.bmp", TEXTURE_OPPOSITE_CAR_1);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_OPPOSITE_CAR_2.bmp", TEXTURE_OPPOSITE_CAR_2);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_OPPOSITE_CAR_3.bmp", TEXTURE_OPPOSITE_CAR_3);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_OPPOSITE_CAR_4.bmp", TEXTURE_OPPOSITE_CAR_4);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_OPPOSITE_CAR_5.bmp", TEXTURE_OPPOSITE_CAR_5);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_OPPOSITE_CAR_6.bmp", TEXTURE_OPPOSITE_CAR_6);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_GAMEOVER.bmp", TEXTURE_GAMEOVER);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_GAMEOVER_CRASH.bmp", TEXTURE_GAMEOVER_CRASH);
-	Texture_Create_Bitmap("assets/GAME_F1RACE_GAMEOVER_FIELD.bmp", TEXTURE_GAMEOVER_FIELD);
+	SDL_Surface *bitmaps[TEXTURE_MAX] = { NULL };
+	SDL_Surface *atlas;
+	SDL_bool loaded;
+	Sint16 height;
+	int span;
+	int i;
+
+	textures[TEXTURE_SCREEN] = SDL_CreateTexture(render, SDL_PIXELFORMAT_RGBA8888,
+		(options.backend == BACKEND_FRAMEBUFFER) ? SDL_TEXTUREACCESS_STREAMING : SDL_TEXTUREACCESS_TARGET,
+		TEXTURE_WIDTH, TEXTURE_HEIGHT);
+	span = Profile_Begin("Texture_Load_Pack", NULL);
+	loaded = Texture_Load_Pack();
+	Profile_End(span);
+	if (loaded)
+		return;
+
+	for (i = 0; i < TEXTURE_MAX; ++i) {
+		SDL_zero(texture_rects[i]);
+		SDL_zero(framebuffer_rects[i]);
+		if (texture_assets[i].path == NULL || (bitmaps[i] = Texture_Load_Bitmap(&texture_assets[i])) == NULL)
+			continue;
+		framebuffer_rects[i].w = bitmaps[i]->w;
+		framebuffer_rects[i].h = bitmaps[i]->h;
+	}
+	height = F1Race_Pack_Atlas(framebuffer_rects, TEXTURE_MAX, TEXTURE_ATLAS_WIDTH, TEXTURE_ATLAS_PADDING);
+	for (i = 0; i < TEXTURE_MAX; ++i) {
+		texture_rects[i].x = framebuffer_rects[i].x;
+		texture_rects[i].y = framebuffer_rects[i].y;
+		texture_rects[i].w = framebuffer_rects[i].w;
+		texture_rects[i].h = framebuffer_rects[i].h;
+	}
+
+	atlas = SDL_CreateRGBSurfaceWithFormat(0, TEXTURE_ATLAS_WIDTH, height, 32, SDL_PIXELFORMAT_RGBA8888);
+	if (atlas == NULL) {
+		fprintf(stderr, "SDL_CreateRGBSurfaceWithFormat Error: %s.\n", SDL_GetError());
+		return;
+	}
+	for (i = 0; i < TEXTURE_MAX; ++i)
+		if (bitmaps[i]) {
+			SDL_SetSurfaceBlendMode(bitmaps[i], SDL_BLENDMODE_NONE); // Copy alpha channel as is.
+			SDL_BlitSurface(bitmaps[i], NULL, atlas, &texture_rects[i]);
+			SDL_FreeSurface(bitmaps[i]);
+		}
+
+	texture_atlas_width = atlas->w;
+	texture_atlas_height = atlas->h;
+	if (options.backend == BACKEND_FRAMEBUFFER) {
+		Texture_Load_Framebuffer_Atlas((const Uint32 *) atlas->pixels, atlas->pitch / sizeof(Uint32));
+		texture_atlas_surface = atlas;
+		return;
+	}
+
+	texture_atlas = SDL_CreateTextureFromSurface(render, atlas);
+	SDL_SetTextureBlendMode(texture_atlas, SDL_BLENDMODE_BLEND);
+	SDL_FreeSurface(atlas);
 }
 
+static void Render_Flush(void);
+
 static void Texture_Draw(Sint32 x, Sint32 y, TEXTURE texture_id) {
-	SDL_Rect rectangle;
-	rectangle.x = x;
-	rectangle.y = y;
-	SDL_QueryTexture(textures[texture_id], NULL, NULL, &rectangle.w, &rectangle.h);
-	SDL_RenderCopy(render, textures[texture_id], NULL, &rectangle);
+	if (F1Race_Draw_Full(&draw_list))
+		Render_Flush();
+	F1Race_Draw_Sprite(&draw_list, texture_id, x, y, texture_rects[texture_id].w, texture_rects[texture_id].h);
 }
 
 static void Texture_Unload(void) {
 	int i = 0;
 	for (; i < TEXTURE_MAX; ++i)
-		if (textures[i])
+		if (textures[i]) {
 			SDL_DestroyTexture(textures[i]);
+			textures[i] = NULL;
+		}
+	if (texture_atlas)
+		SDL_DestroyTexture(texture_atlas);
+	if (texture_atlas_surface)
+		SDL_FreeSurface(texture_atlas_surface);
+	texture_atlas = NULL;
+	texture_atlas_surface = NULL;
+}
+
+static void Render_State(Uint8 kind, Uint32 color) {
+	Uint64 state = ((Uint64) kind << 32) | ((kind == F1RACE_DRAW_FILL) ? color : 0);
+	if (state == draw_submitted_state)
+		return;
+	if (kind == F1RACE_DRAW_FILL)
+		SDL_SetRenderDrawColor(render, color >> 24, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF);
+	draw_submitted_state = state;
+	draw_frame.state_changes++;
+}
+
+static void Render_Submit_Fills(const F1RACE_DRAW_COMMAND *commands, Uint32 count) {
+	static SDL_Rect rectangles[F1RACE_DRAW_MAX_COMMANDS];
+	Uint32 index;
+	for (index = 0; index < count; index++) {
+		rectangles[index].x = commands[index].rect.x;
+		rectangles[index].y = commands[index].rect.y;
+		rectangles[index].w = commands[index].rect.w;
+		rectangles[index].h = commands[index].rect.h;
+	}
+	Render_State(F1RACE_DRAW_FILL, commands[0].color);
+	SDL_RenderFillRects(render, rectangles, count);
+	draw_frame.draw_calls++;
+}
+
+static void Render_Submit_Sprites(const F1RACE_DRAW_COMMAND *commands, Uint32 count) {
+	Uint32 index;
+	Render_State(F1RACE_DRAW_SPRITE, 0);
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	static SDL_Vertex vertices[F1RACE_DRAW_MAX_COMMANDS * 4];
+	static int indices[F1RACE_DRAW_MAX_COMMANDS * 6];
+	const SDL_Color white = { 255, 255, 255, 255 };
+	for (index = 0; index < count; index++) {
+		const F1RACE_DRAW_RECT *target = &commands[index].rect;
+		const SDL_Rect *source = &texture_rects[commands[index].image];
+		SDL_Vertex *vertex = &vertices[index * 4];
+		int *triangle = &indices[index * 6];
+		float u0 = (float) source->x / texture_atlas_width;
+		float v0 = (float) source->y / texture_atlas_height;
+		float u1 = (float) (source->x + source->w) / texture_atlas_width;
+		float v1 = (float) (source->y + source->h) / texture_atlas_height;
+
+		vertex[0].position.x = target->x;              vertex[0].position.y = target->y;
+		vertex[1].position.x = target->x + target->w;  vertex[1].position.y = target->y;
+		vertex[2].position.x = target->x + target->w;  vertex[2].position.y = target->y + target->h;
+		vertex[3].position.x = target->x;              vertex[3].position.y = target->y + target->h;
+		vertex[0].tex_coord.x = u0; vertex[0].tex_coord.y = v0;
+		vertex[1].tex_coord.x = u1; vertex[1].tex_coord.y = v0;
+		vertex[2].tex_coord.x = u1; vertex[2].tex_coord.y = v1;
+		vertex[3].tex_coord.x = u0; vertex[3].tex_coord.y = v1;
+		vertex[0].color = vertex[1].color = vertex[2].color = vertex[3].color = white;
+
+		triangle[0] = index * 4 + 0; triangle[1] = index * 4 + 1; triangle[2] = index * 4 + 2;
+		triangle[3] = index * 4 + 0; triangle[4] = index * 4 + 2; triangle[5] = index * 4 + 3;
+	}
+	SDL_RenderGeometry(render, texture_atlas, vertices, count * 4, indices, count * 6);
+	draw_frame.draw_calls++;
+#else
+	for (index = 0; index < count; index++) {
+		SDL_Rect rectangle;
+		rectangle.x = commands[index].rect.x;
+		rectangle.y = commands[index].rect.y;
+		rectangle.w = commands[index].rect.w;
+		rectangle.h = commands[index].rect.h;
+		SDL_RenderCopy(render, texture_atlas, &texture_rects[commands[index].image], &rectangle);
+		draw_frame.draw_calls++;
+	}
+#endif
+}
+
+/* Sorts the pending commands by state and submits every run of equal state with a single call. */
+static void Render_Flush(void) {
+	const F1RACE_DRAW_COMMAND *commands = draw_list.commands;
+	Uint32 index = 0, end;
+
+	if (options.backend == BACKEND_FRAMEBUFFER)
+		F1Race_Framebuffer_Submit(&framebuffer, &draw_list, &framebuffer_atlas);
+	else
+		F1Race_Draw_Sort(&draw_list);
+	while (options.backend == BACKEND_SDL && index < draw_list.count) {
+		for (end = index + 1; end < draw_list.count; end++)
+			if (commands[end].kind != commands[index].kind ||
+				(commands[end].kind == F1RACE_DRAW_FILL && commands[end].color != commands[index].color))
+				break;
+		if (commands[index].kind == F1RACE_DRAW_FILL)
+			Render_Submit_Fills(&commands[index], end - index);
+		else
+			Render_Submit_Sprites(&commands[index], end - index);
+		index = end;
+	}
+	draw_frame.commands += draw_list.count;
+	if (draw_list.count > 0)
+		render_dirty = SDL_TRUE;
+	F1Race_Draw_Reset(&draw_list);
+}
+
+static void Render_Color(Uint8 r, Uint8 g, Uint8 b) {
+	draw_color = F1RACE_DRAW_RGB(r, g, b);
+}
+
+static void Render_Fill(const SDL_Rect *rectangle) {
+	if (F1Race_Draw_Full(&draw_list))
+		Render_Flush();
+	F1Race_Draw_Fill(&draw_list, draw_color, rectangle->x, rectangle->y, rectangle->w, rectangle->h);
+}
+
+/* Only axis-aligned lines are used, they become one pixel wide fills and batch with other rectangles. */
+static void Render_Line(Sint32 x1, Sint32 y1, Sint32 x2, Sint32 y2) {
+	SDL_Rect rectangle;
+	rectangle.x = SDL_min(x1, x2);
+	rectangle.y = SDL_min(y1, y2);
+	rectangle.w = SDL_max(x1, x2) - rectangle.x + 1;
+	rectangle.h = SDL_max(y1, y2) - rectangle.y + 1;
+	Render_Fill(&rectangle);
+}
+
+static void Render_Outline(const SDL_Rect *rectangle) {
+	Sint32 x2 = rectangle->x + rectangle->w - 1;
+	Sint32 y2 = rectangle->y + rectangle->h - 1;
+	Render_Line(rectangle->x, rectangle->y, x2, rectangle->y);
+	Render_Line(rectangle->x, y2, x2, y2);
+	Render_Line(rectangle->x, rectangle->y + 1, rectangle->x, y2 - 1);
+	Render_Line(x2, rectangle->y + 1, x2, y2 - 1);
+}
+
+static void Render_Clear(void) {
+	Render_Flush();
+	if (options.backend == BACKEND_FRAMEBUFFER)
+		F1Race_Framebuffer_Clear(&framebuffer, draw_color);
+	else {
+		Render_State(F1RACE_DRAW_FILL, draw_color);
+		SDL_RenderClear(render);
+		draw_frame.draw_calls++;
+	}
+	render_dirty = SDL_TRUE;
+}
+
+static void Render_Clip(const SDL_Rect *rectangle) {
+	F1RACE_DRAW_RECT clip;
+	Render_Flush();
+	if (options.backend == BACKEND_SDL) {
+		SDL_RenderSetClipRect(render, rectangle);
+		return;
+	}
+	if (rectangle != NULL) {
+		clip.x = rectangle->x;
+		clip.y = rectangle->y;
+		clip.w = rectangle->w;
+		clip.h = rectangle->h;
+	}
+	F1Race_Framebuffer_Clip(&framebuffer, (rectangle != NULL) ? &clip : NULL);
+}
+
+/* Starts drawing into the screen texture, clipping is reset like SDL_SetRenderTarget() does. */
+static void Render_Begin(SDL_Texture *texture) {
+	if (options.backend == BACKEND_SDL)
+		SDL_SetRenderTarget(render, texture);
+	else
+		F1Race_Framebuffer_Clip(&framebuffer, NULL);
+}
+
+static void Render_End(SDL_Texture *texture) {
+	Render_Flush();
+	if (options.backend == BACKEND_SDL)
+		SDL_SetRenderTarget(render, NULL);
+	else if (render_dirty) {
+		SDL_UpdateTexture(texture, NULL, framebuffer_pixels, TEXTURE_WIDTH * sizeof(Uint32));
+		draw_frame.draw_calls++;
+	}
+}
+
+static void Render_Frame_End(void) {
+	draw_total_commands += draw_frame.commands;
+	draw_total_calls += draw_frame.draw_calls;
+	draw_total_state_changes += draw_frame.state_changes;
+	draw_max.commands = SDL_max(draw_max.commands, draw_frame.commands);
+	draw_max.draw_calls = SDL_max(draw_max.draw_calls, draw_frame.draw_calls);
+	draw_max.state_changes = SDL_max(draw_max.state_changes, draw_frame.state_changes);
+	draw_frames++;
+	SDL_zero(draw_frame);
+}
+
+static void Render_Invalidate(void) {
+	status_drawn.score = status_drawn.level = status_drawn.fly_count = status_drawn.fly_charger_count = -1;
+	road_drawn_valid = SDL_FALSE;
+}
+
+static void Render_Report(void) {
+	if (draw_frames == 0)
+		return;
+	fprintf(stderr, "frames: %u presented, %u skipped without changes\n", draw_frames, draw_skipped_frames);
+	fprintf(stderr, "draw commands per frame: avg=%.2f max=%u\n",
+		(double) draw_total_commands / draw_frames, draw_max.commands);
+	fprintf(stderr, "draw calls per frame:    avg=%.2f max=%u\n",
+		(double) draw_total_calls / draw_frames, draw_max.draw_calls);
+	fprintf(stderr, "state changes per frame: avg=%.2f max=%u\n",
+		(double) draw_total_state_changes / draw_frames, draw_max.state_changes);
 }
 
 static void F1Race_Render_Score(Sint16 x_pos, Sint16 y_pos);
 
 static void F1Race_Show_Game_Over_Screen(void) {
-	SDL_SetRenderDrawColor(render, 234, 243, 255, 0); // Light Blue.
-	SDL_RenderClear(render);
+	Render_Invalidate();
+	Render_Clip(NULL);
+	Render_Color(234, 243, 255); // Light Blue.
+	Render_Clear();
 
 	Texture_Draw(18, 10, TEXTURE_GAMEOVER);
 	Texture_Draw(30, 40, TEXTURE_GAMEOVER_FIELD);
 
 	SDL_Rect rectangle;
-	SDL_SetRenderDrawColor(render, 0, 0, 0, 0);
+	Render_Color(0, 0, 0);
 	rectangle.x = 33;
 	rectangle.y = 43;
 	rectangle.w = 64;
 	rectangle.h = 20;
-	SDL_RenderFillRect(render, &rectangle);
+	Render_Fill(&rectangle);
 
 	Texture_Draw(36, 50, TEXTURE_STATUS_SCORE);
 	Texture_Draw(65, 48, TEXTURE_STATUS_BOX);
@@ -336,77 +1129,50 @@ static void F1Race_Show_Game_Over_Screen(void) {
 	Texture_Draw(47, 80, TEXTURE_GAMEOVER_CRASH);
 }
 
+/* Separators between the lanes of the road, dashes of every second separator are shifted like the classic two. */
 static void F1Race_Render_Separator(void) {
-	Sint16 start_y, end_y;
+	const F1RACE_TRAFFIC *traffic = &f1race_state.traffic;
+	Sint16 start_y, end_y, lane;
 
 	SDL_Rect rectangle;
-	SDL_SetRenderDrawColor(render, 250, 250, 250, 0);
-	rectangle.x = F1RACE_SEPARATOR_0_START_X;
-	rectangle.y = F1RACE_DISPLAY_START_Y;
-	rectangle.w = F1RACE_SEPARATOR_0_END_X + 1 - rectangle.x;
-	rectangle.h = F1RACE_DISPLAY_END_Y - rectangle.y;
-	SDL_RenderFillRect(render, &rectangle);
-
-	SDL_SetRenderDrawColor(render, 250, 250, 250, 0);
-	rectangle.x = F1RACE_SEPARATOR_1_START_X;
-	rectangle.y = F1RACE_DISPLAY_START_Y;
-	rectangle.w = F1RACE_SEPARATOR_1_END_X + 1 - rectangle.x;
-	rectangle.h = F1RACE_DISPLAY_END_Y - rectangle.y;
-	SDL_RenderFillRect(render, &rectangle);
-
-	start_y = f1race_separator_0_block_start_y;
-	end_y = start_y + F1RACE_SEPARATOR_HEIGHT_SPACE;
-	while (SDL_TRUE) {
-		SDL_SetRenderDrawColor(render, 150, 150, 150, 0);
-		rectangle.x = F1RACE_SEPARATOR_0_START_X;
-		rectangle.y = start_y;
-		rectangle.w = F1RACE_SEPARATOR_0_END_X + 1 - rectangle.x;
-		rectangle.h = end_y - rectangle.y;
-		SDL_RenderFillRect(render, &rectangle);
-
-		start_y += F1RACE_SEPARATOR_HEIGHT;
-		end_y = start_y + F1RACE_SEPARATOR_HEIGHT_SPACE;
-		if (start_y > F1RACE_DISPLAY_END_Y)
-			break;
-		if (end_y > F1RACE_DISPLAY_END_Y)
-			end_y = F1RACE_DISPLAY_END_Y;
+	for (lane = 1; lane < road_drawn.lanes; lane++) {
+		Render_Color(250, 250, 250);
+		rectangle.x = traffic->lane_x[lane] - F1RACE_SEPARATOR_WIDTH;
+		rectangle.y = F1RACE_DISPLAY_START_Y;
+		rectangle.w = F1RACE_SEPARATOR_WIDTH;
+		rectangle.h = F1RACE_DISPLAY_END_Y - rectangle.y;
+		Render_Fill(&rectangle);
 	}
-	f1race_separator_0_block_start_y += F1RACE_SEPARATOR_HEIGHT_SPACE;
-	if (f1race_separator_0_block_start_y >=
-		(F1RACE_DISPLAY_START_Y + F1RACE_SEPARATOR_HEIGHT_SPACE * F1RACE_SEPARATOR_RATIO))
-		f1race_separator_0_block_start_y = F1RACE_DISPLAY_START_Y;
 
-	start_y = f1race_separator_1_block_start_y;
-	end_y = start_y + F1RACE_SEPARATOR_HEIGHT_SPACE;
-	while (SDL_TRUE) {
-		SDL_SetRenderDrawColor(render, 150, 150, 150, 0);
-		rectangle.x = F1RACE_SEPARATOR_1_START_X;
-		rectangle.y = start_y;
-		rectangle.w = F1RACE_SEPARATOR_1_END_X + 1 - rectangle.x;
-		rectangle.h = end_y - rectangle.y;
-		SDL_RenderFillRect(render, &rectangle);
-
-		start_y += F1RACE_SEPARATOR_HEIGHT;
+	for (lane = 1; lane < road_drawn.lanes; lane++) {
+		start_y = (lane % 2) ? road_drawn.separator_0_block_start_y : road_drawn.separator_1_block_start_y;
 		end_y = start_y + F1RACE_SEPARATOR_HEIGHT_SPACE;
-		if (start_y > F1RACE_DISPLAY_END_Y)
-			break;
-		if (end_y > F1RACE_DISPLAY_END_Y)
-			end_y = F1RACE_DISPLAY_END_Y;
+		while (SDL_TRUE) {
+			Render_Color(150, 150, 150);
+			rectangle.x = traffic->lane_x[lane] - F1RACE_SEPARATOR_WIDTH;
+			rectangle.y = start_y;
+			rectangle.w = F1RACE_SEPARATOR_WIDTH;
+			rectangle.h = end_y - rectangle.y;
+			Render_Fill(&rectangle);
+
+			start_y += F1RACE_SEPARATOR_HEIGHT;
+			end_y = start_y + F1RACE_SEPARATOR_HEIGHT_SPACE;
+			if (start_y > F1RACE_DISPLAY_END_Y)
+				break;
+			if (end_y > F1RACE_DISPLAY_END_Y)
+				end_y = F1RACE_DISPLAY_END_Y;
+		}
 	}
-	f1race_separator_1_block_start_y += F1RACE_SEPARATOR_HEIGHT_SPACE;
-	if (f1race_separator_1_block_start_y >=
-		(F1RACE_DISPLAY_START_Y + F1RACE_SEPARATOR_HEIGHT_SPACE * F1RACE_SEPARATOR_RATIO))
-		f1race_separator_1_block_start_y = F1RACE_DISPLAY_START_Y;
 }
 
 static void F1Race_Render_Road(void) {
 	SDL_Rect rectangle;
-	SDL_SetRenderDrawColor(render, 150, 150, 150, 0);
+	Render_Color(150, 150, 150);
 	rectangle.x = F1RACE_ROAD_0_START_X;
 	rectangle.y = F1RACE_DISPLAY_START_Y;
 	rectangle.w = F1RACE_ROAD_2_END_X + 1 - rectangle.x;
 	rectangle.h = F1RACE_DISPLAY_END_Y - rectangle.y;
-	SDL_RenderFillRect(render, &rectangle);
+	Render_Fill(&rectangle);
 }
 
 static void F1Race_Render_Score(Sint16 x_pos, Sint16 y_pos) {
@@ -414,15 +1180,15 @@ static void F1Race_Render_Score(Sint16 x_pos, Sint16 y_pos) {
 	Sint16 remain;
 
 	SDL_Rect rectangle;
-	SDL_SetRenderDrawColor(render, 0, 0, 0, 0);
+	Render_Color(0, 0, 0);
 	rectangle.x = x_pos + 4;
 	rectangle.y = y_pos + 52;
 	rectangle.w = x_pos + 29 + 1 - rectangle.x;
 	rectangle.h = y_pos + 58 - rectangle.y;
-	SDL_RenderFillRect(render, &rectangle);
+	Render_Fill(&rectangle);
 
-	value = f1race_score % 10;
-	remain = f1race_score / 10;
+	value = f1race_view.score % 10;
+	remain = f1race_view.score / 10;
 
 	while (SDL_TRUE) {
 		Texture_Draw(x_pos + 25, y_pos + 52, value);
@@ -442,81 +1208,168 @@ static void F1Race_Render_Status(void) {
 	Sint16 y_pos;
 	Sint16 index;
 
-	F1Race_Render_Score(F1RACE_STATUS_START_X, F1RACE_DISPLAY_START_Y);
+	if (status_drawn.score != f1race_view.score) {
+		F1Race_Render_Score(F1RACE_STATUS_START_X, F1RACE_DISPLAY_START_Y);
+		status_drawn.score = f1race_view.score;
+	}
 
 	SDL_Rect rectangle;
-	SDL_SetRenderDrawColor(render, 0, 0, 0, 0);
-	rectangle.x = F1RACE_STATUS_START_X + 4;
-	rectangle.y = F1RACE_DISPLAY_START_Y + 74;
-	rectangle.w = F1RACE_STATUS_START_X + 29 + 1 - rectangle.x;
-	rectangle.h = F1RACE_DISPLAY_START_Y + 80 - rectangle.y;
-	SDL_RenderFillRect(render, &rectangle);
-
-	x_pos = F1RACE_STATUS_START_X + 16;
-	y_pos = F1RACE_DISPLAY_START_Y + 74;
-
-	Texture_Draw(x_pos, y_pos, f1race_level);
-
-	x_pos = F1RACE_STATUS_START_X + 4;
-	y_pos = F1RACE_DISPLAY_START_Y + 102;
-	for (index = 0; index < 5; index++) {
-		if (index < f1race_fly_charger_count)
-			SDL_SetRenderDrawColor(render, 255, 0, 0, 0);
-		else
-			SDL_SetRenderDrawColor(render, 100, 100, 100, 0);
-		rectangle.x = x_pos + index * 4;
-		rectangle.y = y_pos - 2 - index;
-		rectangle.w = x_pos + 2 + index * 4 + 1 - rectangle.x;
-		rectangle.h = y_pos - rectangle.y;
-		SDL_RenderFillRect(render, &rectangle);
+	if (status_drawn.level != f1race_view.level) {
+		Render_Color(0, 0, 0);
+		rectangle.x = F1RACE_STATUS_START_X + 4;
+		rectangle.y = F1RACE_DISPLAY_START_Y + 74;
+		rectangle.w = F1RACE_STATUS_START_X + 29 + 1 - rectangle.x;
+		rectangle.h = F1RACE_DISPLAY_START_Y + 80 - rectangle.y;
+		Render_Fill(&rectangle);
+
+		x_pos = F1RACE_STATUS_START_X + 16;
+		y_pos = F1RACE_DISPLAY_START_Y + 74;
+
+		Texture_Draw(x_pos, y_pos, f1race_view.level);
+		status_drawn.level = f1race_view.level;
+	}
+
+	if (status_drawn.fly_charger_count != f1race_view.fly_charger_count) {
+		x_pos = F1RACE_STATUS_START_X + 4;
+		y_pos = F1RACE_DISPLAY_START_Y + 102;
+		for (index = 0; index < 5; index++) {
+			if (index < f1race_view.fly_charger_count)
+				Render_Color(255, 0, 0);
+			else
+				Render_Color(100, 100, 100);
+			rectangle.x = x_pos + index * 4;
+			rectangle.y = y_pos - 2 - index;
+			rectangle.w = x_pos + 2 + index * 4 + 1 - rectangle.x;
+			rectangle.h = y_pos - rectangle.y;
+			Render_Fill(&rectangle);
+		}
+		status_drawn.fly_charger_count = f1race_view.fly_charger_count;
+	}
+
+	if (status_drawn.fly_count != f1race_view.fly_count) {
+		x_pos = F1RACE_STATUS_START_X + 25;
+		y_pos = F1RACE_DISPLAY_START_Y + 96;
+		Texture_Draw(x_pos, y_pos, f1race_view.fly_count);
+		status_drawn.fly_count = f1race_view.fly_count;
 	}
+}
 
-	x_pos = F1RACE_STATUS_START_X + 25;
-	y_pos = F1RACE_DISPLAY_START_Y + 96;
-	Texture_Draw(x_pos, y_pos, f1race_fly_count);
+/* Sprite of the player car, the fly sprites are larger and centered on the car. */
+static TEXTURE F1Race_Player_Image(void) {
+	if (f1race_view.player_is_car_fly == 0)
+		return TEXTURE_PLAYER_CAR;
+	switch (f1race_view.player_car_fly_duration) {
+		case 0:
+		case 1:
+			return TEXTURE_PLAYER_CAR_FLY_UP;
+		case (F1RACE_PLAYER_CAR_FLY_FRAME_COUNT - 1):
+		case (F1RACE_PLAYER_CAR_FLY_FRAME_COUNT - 2):
+			return TEXTURE_PLAYER_CAR_FLY_DOWN;
+		default:
+			return TEXTURE_PLAYER_CAR_FLY;
+	}
 }
 
 static void F1Race_Render_Player_Car(void) {
 	Sint16 dx;
 	Sint16 dy;
 
-	TEXTURE image;
-
-	if (f1race_player_is_car_fly == SDL_FALSE)
-		Texture_Draw(f1race_player_car.pos_x, f1race_player_car.pos_y, TEXTURE_PLAYER_CAR);
+	if (road_drawn.player_image == TEXTURE_PLAYER_CAR)
+		Texture_Draw(road_drawn.player_x, road_drawn.player_y, TEXTURE_PLAYER_CAR);
 	else {
 		dx = (F1RACE_PLAYER_CAR_FLY_IMAGE_SIZE_X - F1RACE_PLAYER_CAR_IMAGE_SIZE_X) / 2;
 		dy = (F1RACE_PLAYER_CAR_FLY_IMAGE_SIZE_Y - F1RACE_PLAYER_CAR_IMAGE_SIZE_Y) / 2;
-		dx = f1race_player_car.pos_x - dx;
-		dy = f1race_player_car.pos_y - dy;
-		switch (f1race_player_car_fly_duration) {
-			case 0:
-			case 1:
-				image = TEXTURE_PLAYER_CAR_FLY_UP;
-				break;
-			case (F1RACE_PLAYER_CAR_FLY_FRAME_COUNT - 1):
-			case (F1RACE_PLAYER_CAR_FLY_FRAME_COUNT - 2):
-				image = TEXTURE_PLAYER_CAR_FLY_DOWN;
-				break;
-			default:
-				image = TEXTURE_PLAYER_CAR_FLY;
-				break;
-		}
-		Texture_Draw(dx, dy, image);
+		Texture_Draw(road_drawn.player_x - dx, road_drawn.player_y - dy, road_drawn.player_image);
 	}
 }
 
 static void F1Race_Render_Opposite_Car(void) {
 	Sint16 index;
-	for (index = 0; index < F1RACE_OPPOSITE_CAR_COUNT; index++) {
-		if (f1race_opposite_car[index].is_empty == SDL_FALSE)
-			Texture_Draw(f1race_opposite_car[index].pos_x, f1race_opposite_car[index].pos_y,
-				f1race_opposite_car[index].image);
-	}
+	for (index = 0; index < road_drawn.cars; index++)
+		Texture_Draw(road_drawn.car_x[index], road_drawn.car_y[index], road_drawn.car_image[index]);
 }
 
 static void F1Race_Render_Player_Car_Crash(void) {
-	Texture_Draw(f1race_player_car.pos_x, f1race_player_car.pos_y - 5, TEXTURE_PLAYER_CAR_CRASH);
+	road_drawn_valid = SDL_FALSE;
+	Texture_Draw(f1race_view.player_car.pos_x, f1race_view.player_car.pos_y - 5, TEXTURE_PLAYER_CAR_CRASH);
+}
+
+static Sint16 F1Race_Lerp(Sint16 from, Sint16 to, double alpha) {
+	return (Sint16) SDL_floor(from + (to - from) * alpha + 0.5);
+}
+
+/* The view of the current tick, for screens drawn right after a tick or a restore. */
+static void F1Race_View_Current(void) {
+	f1race_view.player_car = f1race_state.player_car;
+	f1race_view.player_is_car_fly = f1race_state.player_is_car_fly;
+	f1race_view.player_car_fly_duration = f1race_state.player_car_fly_duration;
+	f1race_view.separator_0_block_start_y = f1race_state.separator_0_block_start_y;
+	f1race_view.separator_1_block_start_y = f1race_state.separator_1_block_start_y;
+	f1race_view.score = f1race_state.score;
+	f1race_view.level = f1race_state.level;
+	f1race_view.fly_count = f1race_state.fly_count;
+	f1race_view.fly_charger_count = f1race_state.fly_charger_count;
+	f1race_view.alpha = 1.0;
+}
+
+/* Builds the rendered view between the previous and the current tick, alpha is the elapsed fraction of a tick. */
+static void F1Race_Interpolate(double alpha) {
+	F1Race_View_Current();
+	if (f1race_state_previous.is_crashing)
+		return;
+
+	f1race_view.player_car.pos_x =
+		F1Race_Lerp(f1race_state_previous.player_car.pos_x, f1race_state.player_car.pos_x, alpha);
+	f1race_view.player_car.pos_y =
+		F1Race_Lerp(f1race_state_previous.player_car.pos_y, f1race_state.player_car.pos_y, alpha);
+
+	f1race_view.separator_0_block_start_y = F1Race_Lerp(f1race_state_previous.separator_0_block_start_y,
+		f1race_state_previous.separator_0_block_start_y + F1RACE_SEPARATOR_HEIGHT_SPACE, alpha);
+	f1race_view.separator_1_block_start_y = F1Race_Lerp(f1race_state_previous.separator_1_block_start_y,
+		f1race_state_previous.separator_1_block_start_y + F1RACE_SEPARATOR_HEIGHT_SPACE, alpha);
+	f1race_view.alpha = alpha;
+}
+
+/*
+ * The view only changes on ticks and when interpolation moves a sprite by a whole pixel. Cars are placed
+ * straight from the two states, a slot taken by a new car since the previous tick is not interpolated, and
+ * only the drawn ones are compared and copied.
+ */
+static SDL_bool F1Race_Road_Changed(void) {
+	const F1RACE_TRAFFIC *from = &f1race_state_previous.traffic;
+	const F1RACE_TRAFFIC *to = &f1race_state.traffic;
+	Sint16 index, y, cars = 0;
+
+	road_view.lanes = f1race_state.traffic_config.lanes;
+	road_view.separator_0_block_start_y = f1race_view.separator_0_block_start_y;
+	road_view.separator_1_block_start_y = f1race_view.separator_1_block_start_y;
+	road_view.player_x = f1race_view.player_car.pos_x;
+	road_view.player_y = f1race_view.player_car.pos_y;
+	road_view.player_image = F1Race_Player_Image();
+	for (index = F1Race_Traffic_Next(to, 0); index >= 0; index = F1Race_Traffic_Next(to, index + 1)) {
+		y = to->pos_y[index];
+		if (f1race_view.alpha < 1.0 && F1RACE_TRAFFIC_IS_ACTIVE(from, index) && y >= from->pos_y[index])
+			y = F1Race_Lerp(from->pos_y[index], y, f1race_view.alpha);
+		if (y + to->dy[index] > F1RACE_DISPLAY_START_Y) {
+			road_view.car_x[cars] = to->pos_x[index];
+			road_view.car_y[cars] = y;
+			road_view.car_image[cars] = TEXTURE_OPPOSITE_CAR_0 + to->image[index];
+			cars++;
+		}
+	}
+	road_view.cars = cars;
+
+	if (road_drawn_valid && !memcmp(&road_drawn, &road_view, offsetof(ROAD, car_x)) &&
+		!memcmp(road_drawn.car_x, road_view.car_x, cars * sizeof(Sint16)) &&
+		!memcmp(road_drawn.car_y, road_view.car_y, cars * sizeof(Sint16)) &&
+		!memcmp(road_drawn.car_image, road_view.car_image, cars * sizeof(Sint16)))
+		return SDL_FALSE;
+	memcpy(&road_drawn, &road_view, offsetof(ROAD, car_x));
+	memcpy(road_drawn.car_x, road_view.car_x, cars * sizeof(Sint16));
+	memcpy(road_drawn.car_y, road_view.car_y, cars * sizeof(Sint16));
+	memcpy(road_drawn.car_image, road_view.car_image, cars * sizeof(Sint16));
+	road_drawn_valid = SDL_TRUE;
+	return SDL_TRUE;
 }
 
 static void F1Race_Render(void) {
@@ -525,7 +1378,7 @@ static void F1Race_Render(void) {
 	rectangle.y = F1RACE_DISPLAY_START_Y;
 	rectangle.w = F1RACE_STATUS_END_X + 1 - rectangle.x;
 	rectangle.h = F1RACE_DISPLAY_END_Y - rectangle.y;
-	SDL_RenderSetClipRect(render, &rectangle);
+	Render_Clip(&rectangle);
 
 	F1Race_Render_Status();
 
@@ -533,7 +1386,10 @@ static void F1Race_Render(void) {
 	rectangle.y = F1RACE_DISPLAY_START_Y;
 	rectangle.w = F1RACE_ROAD_2_END_X + 1 - rectangle.x;
 	rectangle.h = F1RACE_DISPLAY_END_Y - rectangle.y;
-	SDL_RenderSetClipRect(render, &rectangle);
+	Render_Clip(&rectangle);
+
+	if (!F1Race_Road_Changed())
+		return;
 
 	F1Race_Render_Road();
 	F1Race_Render_Separator();
@@ -544,52 +1400,55 @@ static void F1Race_Render(void) {
 static void F1Race_Render_Background(void) {
 	SDL_Rect rectangle;
 
-	SDL_SetRenderDrawColor(render, 255, 255, 255, 0);
-	SDL_RenderClear(render);
+	Render_Invalidate();
+	Render_Clip(NULL);
+
+	Render_Color(255, 255, 255);
+	Render_Clear();
 
-	SDL_SetRenderDrawColor(render, 0, 0, 0, 0);
+	Render_Color(0, 0, 0);
 	rectangle.x = F1RACE_DISPLAY_START_X - 1;
 	rectangle.y = F1RACE_DISPLAY_START_Y - 1;
 	rectangle.w = F1RACE_DISPLAY_END_X + 2 - rectangle.x;
 	rectangle.h = F1RACE_DISPLAY_END_Y + 1 - rectangle.y;
-	SDL_RenderDrawRect(render, &rectangle);
+	Render_Outline(&rectangle);
 
-	SDL_SetRenderDrawColor(render, 130, 230, 100, 0);
+	Render_Color(130, 230, 100);
 	rectangle.x = F1RACE_GRASS_0_START_X;
 	rectangle.y = F1RACE_DISPLAY_START_Y;
 	rectangle.w = F1RACE_GRASS_0_END_X + 1 - rectangle.x;
 	rectangle.h = F1RACE_DISPLAY_END_Y - rectangle.y;
-	SDL_RenderFillRect(render, &rectangle);
+	Render_Fill(&rectangle);
 
-	SDL_SetRenderDrawColor(render, 100, 180, 100, 0);
-	SDL_RenderDrawLine(render, F1RACE_GRASS_0_END_X - 1,
+	Render_Color(100, 180, 100);
+	Render_Line(F1RACE_GRASS_0_END_X - 1,
 		F1RACE_DISPLAY_START_Y, F1RACE_GRASS_0_END_X - 1, F1RACE_DISPLAY_END_Y - 1);
 
-	SDL_SetRenderDrawColor(render, 0, 0, 0, 0);
-	SDL_RenderDrawLine(render, F1RACE_GRASS_0_END_X,
+	Render_Color(0, 0, 0);
+	Render_Line(F1RACE_GRASS_0_END_X,
 		F1RACE_DISPLAY_START_Y, F1RACE_GRASS_0_END_X, F1RACE_DISPLAY_END_Y);
 
-	SDL_SetRenderDrawColor(render, 130, 230, 100, 0);
+	Render_Color(130, 230, 100);
 	rectangle.x = F1RACE_GRASS_1_START_X;
 	rectangle.y = F1RACE_DISPLAY_START_Y;
 	rectangle.w = F1RACE_GRASS_1_END_X + 1 - rectangle.x;
 	rectangle.h = F1RACE_DISPLAY_END_Y - rectangle.y;
-	SDL_RenderFillRect(render, &rectangle);
+	Render_Fill(&rectangle);
 
-	SDL_SetRenderDrawColor(render, 100, 180, 100, 0);
-	SDL_RenderDrawLine(render, F1RACE_GRASS_1_START_X + 1,
+	Render_Color(100, 180, 100);
+	Render_Line(F1RACE_GRASS_1_START_X + 1,
 		F1RACE_DISPLAY_START_Y, F1RACE_GRASS_1_START_X + 1, F1RACE_DISPLAY_END_Y - 1);
 
-	SDL_SetRenderDrawColor(render, 0, 0, 0, 0);
-	SDL_RenderDrawLine(render, F1RACE_GRASS_1_START_X,
+	Render_Color(0, 0, 0);
+	Render_Line(F1RACE_GRASS_1_START_X,
 		F1RACE_DISPLAY_START_Y, F1RACE_GRASS_1_START_X, F1RACE_DISPLAY_END_Y);
 
-	SDL_SetRenderDrawColor(render, 0, 0, 0, 0);
+	Render_Color(0, 0, 0);
 	rectangle.x = F1RACE_STATUS_START_X;
 	rectangle.y = F1RACE_DISPLAY_START_Y;
 	rectangle.w = F1RACE_STATUS_END_X + 1 - rectangle.x;
 	rectangle.h = F1RACE_DISPLAY_END_Y - rectangle.y;
-	SDL_RenderFillRect(render, &rectangle);
+	Render_Fill(&rectangle);
 
 	Texture_Draw(F1RACE_STATUS_START_X + 0, F1RACE_DISPLAY_START_Y +  0, TEXTURE_LOGO);
 	Texture_Draw(F1RACE_STATUS_START_X + 5, F1RACE_DISPLAY_START_Y + 42, TEXTURE_STATUS_SCORE);
@@ -599,86 +1458,7 @@ static void F1Race_Render_Background(void) {
 	Texture_Draw(F1RACE_STATUS_START_X + 2, F1RACE_DISPLAY_START_Y + 89, TEXTURE_STATUS_FLY);
 }
 
-static void F1Race_Init(void) {
-	int index;
-	f1race_key_up_pressed = SDL_FALSE;
-	f1race_key_down_pressed = SDL_FALSE;
-	f1race_key_right_pressed = SDL_FALSE;
-	f1race_key_left_pressed = SDL_FALSE;
-
-	f1race_separator_0_block_start_y = F1RACE_DISPLAY_START_Y;
-	f1race_separator_1_block_start_y = F1RACE_DISPLAY_START_Y + F1RACE_SEPARATOR_HEIGHT_SPACE * 3;
-	f1race_player_car.pos_x = ((F1RACE_ROAD_1_START_X + F1RACE_ROAD_1_END_X - F1RACE_PLAYER_CAR_IMAGE_SIZE_X) / 2);
-	f1race_player_car.dx = F1RACE_PLAYER_CAR_IMAGE_SIZE_X;
-	f1race_player_car.pos_y = F1RACE_DISPLAY_END_Y - F1RACE_PLAYER_CAR_IMAGE_SIZE_Y - 1;
-	f1race_player_car.dy = F1RACE_PLAYER_CAR_IMAGE_SIZE_Y;
-	f1race_player_car.image = TEXTURE_PLAYER_CAR;
-	f1race_player_car.image_fly = TEXTURE_PLAYER_CAR_FLY;
-	f1race_player_car.image_head_light = TEXTURE_PLAYER_CAR_HEAD_LIGHT;
-
-	f1race_opposite_car_type[0].dx = F1RACE_OPPOSITE_CAR_0_IMAGE_SIZE_X;
-	f1race_opposite_car_type[0].dy = F1RACE_OPPOSITE_CAR_0_IMAGE_SIZE_Y;
-	f1race_opposite_car_type[0].image = TEXTURE_OPPOSITE_CAR_0;
-	f1race_opposite_car_type[0].speed = 3;
-	f1race_opposite_car_type[0].dx_from_road = (F1RACE_ROAD_WIDTH - F1RACE_OPPOSITE_CAR_0_IMAGE_SIZE_X) / 2;
-
-	f1race_opposite_car_type[1].dx = F1RACE_OPPOSITE_CAR_1_IMAGE_SIZE_X;
-	f1race_opposite_car_type[1].dy = F1RACE_OPPOSITE_CAR_1_IMAGE_SIZE_Y;
-	f1race_opposite_car_type[1].image = TEXTURE_OPPOSITE_CAR_1;
-	f1race_opposite_car_type[1].speed = 4;
-	f1race_opposite_car_type[1].dx_from_road = (F1RACE_ROAD_WIDTH - F1RACE_OPPOSITE_CAR_1_IMAGE_SIZE_X) / 2;
-
-	f1race_opposite_car_type[2].dx = F1RACE_OPPOSITE_CAR_2_IMAGE_SIZE_X;
-	f1race_opposite_car_type[2].dy = F1RACE_OPPOSITE_CAR_2_IMAGE_SIZE_Y;
-	f1race_opposite_car_type[2].image = TEXTURE_OPPOSITE_CAR_2;
-	f1race_opposite_car_type[2].speed = 6;
-	f1race_opposite_car_type[2].dx_from_road = (F1RACE_ROAD_WIDTH - F1RACE_OPPOSITE_CAR_2_IMAGE_SIZE_X) / 2;
-
-	f1race_opposite_car_type[3].dx = F1RACE_OPPOSITE_CAR_3_IMAGE_SIZE_X;
-	f1race_opposite_car_type[3].dy = F1RACE_OPPOSITE_CAR_3_IMAGE_SIZE_Y;
-	f1race_opposite_car_type[3].image = TEXTURE_OPPOSITE_CAR_3;
-	f1race_opposite_car_type[3].speed = 3;
-	f1race_opposite_car_type[3].dx_from_road = (F1RACE_ROAD_WIDTH - F1RACE_OPPOSITE_CAR_3_IMAGE_SIZE_X) / 2;
-
-	f1race_opposite_car_type[4].dx = F1RACE_OPPOSITE_CAR_4_IMAGE_SIZE_X;
-	f1race_opposite_car_type[4].dy = F1RACE_OPPOSITE_CAR_4_IMAGE_SIZE_Y;
-	f1race_opposite_car_type[4].image = TEXTURE_OPPOSITE_CAR_4;
-	f1race_opposite_car_type[4].speed = 3;
-	f1race_opposite_car_type[4].dx_from_road = (F1RACE_ROAD_WIDTH - F1RACE_OPPOSITE_CAR_4_IMAGE_SIZE_X) / 2;
-
-	f1race_opposite_car_type[5].dx = F1RACE_OPPOSITE_CAR_5_IMAGE_SIZE_X;
-	f1race_opposite_car_type[5].dy = F1RACE_OPPOSITE_CAR_5_IMAGE_SIZE_Y;
-	f1race_opposite_car_type[5].image = TEXTURE_OPPOSITE_CAR_5;
-	f1race_opposite_car_type[5].speed = 5;
-	f1race_opposite_car_type[5].dx_from_road = (F1RACE_ROAD_WIDTH - F1RACE_OPPOSITE_CAR_5_IMAGE_SIZE_X) / 2;
-
-	f1race_opposite_car_type[6].dx = F1RACE_OPPOSITE_CAR_6_IMAGE_SIZE_X;
-	f1race_opposite_car_type[6].dy = F1RACE_OPPOSITE_CAR_6_IMAGE_SIZE_Y;
-	f1race_opposite_car_type[6].image = TEXTURE_OPPOSITE_CAR_6;
-	f1race_opposite_car_type[6].speed = 3;
-	f1race_opposite_car_type[6].dx_from_road = (F1RACE_ROAD_WIDTH - F1RACE_OPPOSITE_CAR_6_IMAGE_SIZE_X) / 2;
-
-	for (index = 0; index < F1RACE_OPPOSITE_CAR_COUNT; index++) {
-		f1race_opposite_car[index].is_empty = SDL_TRUE;
-		f1race_opposite_car[index].is_add_score = SDL_FALSE;
-	}
-
-	f1race_is_crashing = SDL_FALSE;
-	f1race_last_car_road = 0;
-	f1race_player_is_car_fly = SDL_FALSE;
-	f1race_score = 0;
-	f1race_level = 1;
-	f1race_pass = 0;
-	f1race_fly_count = 1;
-	f1race_fly_charger_count = 0;
-}
-
 static void F1Race_Main(void) {
-	if (f1race_is_new_game != SDL_FALSE) {
-		F1Race_Init();
-		f1race_is_new_game = SDL_FALSE;
-	}
-
 	F1Race_Render_Background();
 	F1Race_Render();
 
@@ -689,50 +1469,43 @@ static void F1Race_Main(void) {
 }
 
 static void F1Race_Key_Left_Pressed(void) {
-	F1RACE_RELEASE_ALL_KEY;
-	f1race_key_left_pressed = SDL_TRUE;
+	F1RACE_IGNORE_KEY_WHEN_CRASHING;
+	f1race_input |= F1RACE_INPUT_LEFT;
 }
 
 static void F1Race_Key_Left_Released(void) {
-	f1race_key_left_pressed = SDL_FALSE;
+	f1race_input &= ~F1RACE_INPUT_LEFT;
 }
 
 static void F1Race_Key_Right_Pressed(void) {
-	F1RACE_RELEASE_ALL_KEY;
-	f1race_key_right_pressed = SDL_TRUE;
+	F1RACE_IGNORE_KEY_WHEN_CRASHING;
+	f1race_input |= F1RACE_INPUT_RIGHT;
 }
 
 static void F1Race_Key_Right_Released(void) {
-	f1race_key_right_pressed = SDL_FALSE;
+	f1race_input &= ~F1RACE_INPUT_RIGHT;
 }
 
 static void F1Race_Key_Up_Pressed(void) {
-	F1RACE_RELEASE_ALL_KEY;
-	f1race_key_up_pressed = SDL_TRUE;
+	F1RACE_IGNORE_KEY_WHEN_CRASHING;
+	f1race_input |= F1RACE_INPUT_UP;
 }
 
 static void F1Race_Key_Up_Released(void) {
-	f1race_key_up_pressed = SDL_FALSE;
+	f1race_input &= ~F1RACE_INPUT_UP;
 }
 
 static void F1Race_Key_Down_Pressed(void) {
-	F1RACE_RELEASE_ALL_KEY;
-	f1race_key_down_pressed = SDL_TRUE;
+	F1RACE_IGNORE_KEY_WHEN_CRASHING;
+	f1race_input |= F1RACE_INPUT_DOWN;
 }
 
 static void F1Race_Key_Down_Released(void) {
-	f1race_key_down_pressed = SDL_FALSE;
+	f1race_input &= ~F1RACE_INPUT_DOWN;
 }
 
 static void F1Race_Key_Fly_Pressed(void) {
-	if (f1race_player_is_car_fly != SDL_FALSE)
-		return;
-
-	if (f1race_fly_count > 0) {
-		f1race_player_is_car_fly = SDL_TRUE;
-		f1race_player_car_fly_duration = 0;
-		f1race_fly_count--;
-	}
+	f1race_input |= F1RACE_INPUT_FLY;
 }
 
 static void F1Race_Keyboard_Key_Handler(Sint32 vkey_code, Sint32 key_state) {
@@ -780,13 +1553,27 @@ static void F1Race_Keyboard_Key_Handler(Sint32 vkey_code, Sint32 key_state) {
 		case SDLK_KP_7:
 			if (key_state) {
 				if (volume_old == -1)
-					volume_old = Mix_VolumeMusic(0);
+					volume_old = Music_Volume(0);
 				else {
-					Mix_VolumeMusic(volume_old);
+					Music_Volume(volume_old);
 					volume_old = -1;
 				}
 			}
 			break;
+		case SDLK_BACKSPACE:
+		case SDLK_KP_PERIOD:
+			f1race_rewinding = (key_state) ? SDL_TRUE : SDL_FALSE;
+			break;
+		case SDLK_F5:
+			if (key_state && !F1Race_Snapshot_Save(&f1race_state, options.state))
+				fprintf(stderr, "State Error: cannot save \"%s\".\n", options.state);
+			break;
+		case SDLK_F9:
+			if (key_state && f1race_recorder.file)
+				fprintf(stderr, "State Error: states are not loaded while recording a replay.\n");
+			else if (key_state)
+				f1race_load_pending = SDL_TRUE;
+			break;
 		case SDLK_ESCAPE:
 			if (key_state)
 				exit_main_loop = SDL_TRUE;
@@ -794,355 +1581,656 @@ static void F1Race_Keyboard_Key_Handler(Sint32 vkey_code, Sint32 key_state) {
 	}
 }
 
-/* === LOGIC CODE === */
-
-static void F1Race_Crashing(void) {
-	Music_Play(MUSIC_CRASH, 0);
-
-	f1race_is_crashing = SDL_TRUE;
-	f1race_crashing_count_down = 50;
+/* Redraws the whole screen texture after the renderer lost its contents. */
+static void F1Race_Repaint(void) {
+	F1Race_Render_Background();
+	if (f1race_state.is_crashing == 0 || f1race_state.crashing_count_down >= F1RACE_GAME_OVER_COUNT_DOWN) {
+		F1Race_Render();
+		if (f1race_state.is_crashing && f1race_state.crashing_count_down < F1RACE_CRASHING_COUNT_DOWN)
+			F1Race_Render_Player_Car_Crash();
+	} else
+		F1Race_Show_Game_Over_Screen();
 }
 
-static void F1Race_New_Opposite_Car(void) {
-	Sint16 index;
-	Sint16 validIndex = 0;
-	Sint16 no_slot;
-	Sint16 car_type = 0;
-	Uint8 road;
-	Sint16 car_pos_x = 0;
-	Sint16 car_shift;
-	Sint16 enough_space;
-	Sint16 rand_num;
-	Sint16 speed_add;
-
-	no_slot = SDL_TRUE;
-	if ((rand() % F1RACE_OPPOSITE_CAR_DEFAULT_APPEAR_RATE) == 0) {
-		for (index = 0; index < F1RACE_OPPOSITE_CAR_COUNT; index++) {
-			if (f1race_opposite_car[index].is_empty != SDL_FALSE) {
-				validIndex = index;
-				no_slot = SDL_FALSE;
-				break;
-			}
-		}
-	}
-
-	if (no_slot != SDL_FALSE)
-		return;
+static SDL_bool F1Race_Game_Over_Shown(const F1RACE_STATE *state) {
+	return state->is_crashing && state->crashing_count_down < F1RACE_GAME_OVER_COUNT_DOWN;
+}
 
-	road = rand() % 3;
+static SDL_bool F1Race_Load_State(const char *path) {
+	F1RACE_FILE_MAPPING mapping;
+	SDL_bool loaded;
 
-	if (road == f1race_last_car_road) {
-		road++;
-		road %= 3;
+	if (!F1Race_File_Map(&mapping, path)) {
+		fprintf(stderr, "State Error: cannot map \"%s\".\n", path);
+		return SDL_FALSE;
 	}
+	loaded = F1Race_Snapshot_Load(&f1race_state, mapping.data, mapping.size, options.rules) ? SDL_TRUE : SDL_FALSE;
+	if (!loaded)
+		fprintf(stderr, "State Error: \"%s\" is not a state of this build and rules.\n", path);
+	F1Race_File_Unmap(&mapping);
+	return loaded;
+}
 
-	if (f1race_level < 3) {
-		rand_num = rand() % 11;
-		switch (rand_num) {
-			case 0:
-			case 1:
-				car_type = 0;
-				break;
-			case 2:
-			case 3:
-			case 4:
-				car_type = 1;
-				break;
-			case 5:
-				car_type = 2;
-				break;
-			case 6:
-			case 7:
-				car_type = 3;
-				break;
-			case 8:
-				car_type = 4;
-				break;
-			case 9:
-				car_type = 5;
-				break;
-			case 10:
-				car_type = 6;
-				break;
-		}
-	}
+/*
+ * Rewinds a tick or loads the state file instead of the tick, replays keep inputs from the seed only, so
+ * neither works while recording. The screen is drawn from scratch, a game back from "Game Over" gets its music.
+ */
+static SDL_bool F1Race_Restore_Tick(void) {
+	SDL_bool game_over = F1Race_Game_Over_Shown(&f1race_state);
+	SDL_bool restored = SDL_FALSE;
+
+	if (f1race_load_pending)
+		restored = F1Race_Load_State(options.state);
+	else if (f1race_rewinding)
+		restored = F1Race_Rewind_Back(&f1race_rewind, 0, &f1race_state) ? SDL_TRUE : SDL_FALSE;
+	f1race_load_pending = SDL_FALSE;
+	if (!restored)
+		return f1race_rewinding;
+
+	f1race_input &= ~F1RACE_INPUT_FLY;
+	f1race_state_previous = f1race_state;
+	F1Race_View_Current();
+	if (game_over && !F1Race_Game_Over_Shown(&f1race_state))
+		F1Race_Main();
+	else
+		F1Race_Repaint();
+	return SDL_TRUE;
+}
 
-	if (f1race_level >= 3) {
-		rand_num = rand() % 11;
-		switch (rand_num) {
-			case 0:
-				car_type = 0;
-				break;
-			case 1:
-			case 2:
-				car_type = 1;
-				break;
-			case 3:
-			case 4:
-				car_type = 2;
-				break;
-			case 5:
-			case 6:
-				car_type = 3;
-				break;
-			case 7:
-				car_type = 4;
-				break;
-			case 8:
-			case 9:
-				car_type = 5;
-				break;
-			case 10:
-				car_type = 6;
-				break;
-		}
-	}
-	enough_space = SDL_TRUE;
-	for (index = 0; index < F1RACE_OPPOSITE_CAR_COUNT; index++) {
-		if ((f1race_opposite_car[index].is_empty == SDL_FALSE) &&
-			(f1race_opposite_car[index].pos_y < (F1RACE_PLAYER_CAR_IMAGE_SIZE_Y * 1.5)))
-			enough_space = SDL_FALSE;
-	}
+static void F1Race_Cyclic_Timer(void) {
+	Uint32 events;
 
-	if (enough_space == SDL_FALSE)
+	if (f1race_recorder.file)
+		F1Race_Replay_Record_Tick(&f1race_recorder, f1race_input);
+	else if (F1Race_Restore_Tick())
 		return;
+	F1Race_Rewind_Push(&f1race_rewind, &f1race_state);
+	f1race_state_previous = f1race_state;
+	events = F1Race_Step(&f1race_state, f1race_input);
+	f1race_input &= ~F1RACE_INPUT_FLY;
+
+	if (events & F1RACE_EVENT_CRASH)
+		Sound_Play(SOUND_CRASH);
+
+	if (f1race_state.is_crashing == 0 && (events & F1RACE_EVENT_NEW_GAME) == 0)
+		return; /* Rendered every frame by main_loop(). */
+	F1Race_View_Current();
+	if (events & F1RACE_EVENT_NEW_GAME) {
+		f1race_input = 0;
+		F1Race_Main();
+	} else if (events & F1RACE_EVENT_CRASH)
+		F1Race_Render();
+	else if (f1race_state.crashing_count_down == F1RACE_CRASHING_COUNT_DOWN - 1)
+		F1Race_Render_Player_Car_Crash();
+	else if (events & F1RACE_EVENT_GAME_OVER) {
+		Music_Stop(); // The "Game Over" screen was always silent besides its own sound.
+		Sound_Play(SOUND_GAMEOVER);
+		F1Race_Show_Game_Over_Screen();
+	}
+	/* Crash and "Game Over" screens are static, nothing to redraw until the next game. */
+}
 
-	speed_add = f1race_level - 1;
-
-	f1race_opposite_car[validIndex].is_empty = SDL_FALSE;
-	f1race_opposite_car[validIndex].is_add_score = SDL_FALSE;
-	f1race_opposite_car[validIndex].dx = f1race_opposite_car_type[car_type].dx;
-	f1race_opposite_car[validIndex].dy = f1race_opposite_car_type[car_type].dy;
-	f1race_opposite_car[validIndex].speed = f1race_opposite_car_type[car_type].speed + speed_add;
-	f1race_opposite_car[validIndex].dx_from_road = f1race_opposite_car_type[car_type].dx_from_road;
-	f1race_opposite_car[validIndex].image = f1race_opposite_car_type[car_type].image;
+static void Latency_Key_Down(Uint64 counter) {
+	if (latency.applying_count < F1RACE_LATENCY_PENDING)
+		latency.applying[latency.applying_count++] = counter;
+}
 
-	car_shift = f1race_opposite_car[validIndex].dx_from_road;
+static void Latency_Sample(float *samples, Uint32 *count, Uint64 from, Uint64 to) {
+	if (*count < F1RACE_LATENCY_SAMPLES)
+		samples[(*count)++] = (float) ((to - from) * 1000.0 / SDL_GetPerformanceFrequency());
+}
 
-	switch (road) {
-	case 0:
-		car_pos_x = F1RACE_ROAD_0_START_X + car_shift;
-		break;
-	case 1:
-		car_pos_x = F1RACE_ROAD_1_START_X + car_shift;
-		break;
-	case 2:
-		car_pos_x = F1RACE_ROAD_2_START_X + car_shift;
-		break;
+static void Latency_Tick(Uint64 counter) {
+	Uint32 index;
+	for (index = 0; index < latency.applying_count; index++) {
+		Latency_Sample(latency.state_samples, &latency.state_count, latency.applying[index], counter);
+		if (latency.presenting_count < F1RACE_LATENCY_PENDING)
+			latency.presenting[latency.presenting_count++] = latency.applying[index];
 	}
+	latency.applying_count = 0;
+}
 
-	f1race_opposite_car[validIndex].pos_x = car_pos_x;
-	f1race_opposite_car[validIndex].pos_y = F1RACE_DISPLAY_START_Y - f1race_opposite_car[validIndex].dy;
-	f1race_opposite_car[validIndex].road_id = road;
+static void Latency_Present(Uint64 counter) {
+	Uint32 index;
+	for (index = 0; index < latency.presenting_count; index++)
+		Latency_Sample(latency.present_samples, &latency.present_count, latency.presenting[index], counter);
+	latency.presenting_count = 0;
+}
 
-	f1race_last_car_road = road;
+static int Latency_Compare(const void *a, const void *b) {
+	float x = *(const float *) a;
+	float y = *(const float *) b;
+	return (x > y) - (x < y);
 }
 
-static void F1Race_CollisionCheck(void) {
-	Sint16 index;
-	Sint16 minA_x, minA_y, maxA_x, maxA_y;
-	Sint16 minB_x, minB_y, maxB_x, maxB_y;
-
-	minA_x = f1race_player_car.pos_x - 1;
-	maxA_x = minA_x + f1race_player_car.dx - 1;
-	minA_y = f1race_player_car.pos_y - 1;
-	maxA_y = minA_y + f1race_player_car.dy - 1;
-
-	for (index = 0; index < F1RACE_OPPOSITE_CAR_COUNT; index++) {
-		if (f1race_opposite_car[index].is_empty == SDL_FALSE) {
-			minB_x = f1race_opposite_car[index].pos_x - 1;
-			maxB_x = minB_x + f1race_opposite_car[index].dx - 1;
-			minB_y = f1race_opposite_car[index].pos_y - 1;
-			maxB_y = minB_y + f1race_opposite_car[index].dy - 1;
-			if (((minA_x <= minB_x) && (minB_x <= maxA_x)) || ((minA_x <= maxB_x) && (maxB_x <= maxA_x))) {
-				if (((minA_y <= minB_y) && (minB_y <= maxA_y)) || ((minA_y <= maxB_y) && (maxB_y <= maxA_y))) {
-					F1Race_Crashing();
-					return;
-				}
-			}
+static void Latency_Report_Samples(const char *name, float *samples, Uint32 count) {
+	if (count == 0) {
+		fprintf(stderr, "%-28s no samples\n", name);
+		return;
+	}
+	qsort(samples, count, sizeof(float), Latency_Compare);
+	fprintf(stderr, "%-28s n=%u p50=%.2f p90=%.2f p99=%.2f max=%.2f ms\n", name, count,
+		samples[count * 50 / 100], samples[count * 90 / 100], samples[count * 99 / 100], samples[count - 1]);
+}
 
-			if ((minA_x >= minB_x) && (minA_x <= maxB_x) && (minA_y >= minB_y) && (minA_y <= maxB_y)) {
-				F1Race_Crashing();
-				return;
-			}
+static void Latency_Report(void) {
+	Latency_Report_Samples("key-down to state change:", latency.state_samples, latency.state_count);
+	Latency_Report_Samples("key-down to present:", latency.present_samples, latency.present_count);
+	Audio_Report();
+}
 
-			if ((minA_x >= minB_x) && (minA_x <= maxB_x) && (maxA_y >= minB_y) && (maxA_y <= maxB_y)) {
-				F1Race_Crashing();
-				return;
-			}
+static void Startup_Report(void) {
+	double frequency = (double) SDL_GetPerformanceFrequency();
+	if (startup.first_frame != 0)
+		fprintf(stderr, "startup: first frame presented after %.2f ms\n",
+			(startup.first_frame - startup.start) * 1000.0 / frequency);
+	if (startup.audio_ready != 0)
+		fprintf(stderr, "startup: audio %s after %.2f ms\n", (audio.state == AUDIO_READY) ? "ready" : "failed",
+			(startup.audio_ready - startup.start) * 1000.0 / frequency);
+}
 
-			if ((maxA_x >= minB_x) && (maxA_x <= maxB_x) && (minA_y >= minB_y) && (minA_y <= maxB_y)) {
-				F1Race_Crashing();
-				return;
-			}
+static void main_loop_event(const SDL_Event *event) {
+	Uint8 input = f1race_input;
+	Uint64 counter;
+	Uint32 age;
 
-			if ((maxA_x >= minB_x) && (maxA_x <= maxB_x) && (maxA_y >= minB_y) && (maxA_y <= maxB_y)) {
-				F1Race_Crashing();
-				return;
+	switch (event->type) {
+		case SDL_QUIT:
+			exit_main_loop = SDL_TRUE;
+			break;
+		case SDL_KEYDOWN:
+			F1Race_Keyboard_Key_Handler(event->key.keysym.sym, SDL_TRUE);
+			if (options.latency && event->key.repeat == 0 && f1race_input != input) {
+				counter = SDL_GetPerformanceCounter();
+				age = SDL_GetTicks() - event->key.timestamp; // Time spent in the event queue.
+				if ((Sint32) age < 0)
+					age = 0;
+				Latency_Key_Down(counter - (Uint64) age * SDL_GetPerformanceFrequency() / 1000);
 			}
+			break;
+		case SDL_KEYUP:
+			F1Race_Keyboard_Key_Handler(event->key.keysym.sym, SDL_FALSE);
+			break;
+		case SDL_WINDOWEVENT:
+			render_dirty = SDL_TRUE; // Exposed or resized window needs a present.
+			break;
+		case SDL_RENDER_TARGETS_RESET:
+		case SDL_RENDER_DEVICE_RESET:
+			if (options.backend == BACKEND_SDL)
+				render_repaint = SDL_TRUE;
+			render_dirty = SDL_TRUE; // The framebuffer backend uploads the whole screen on every present.
+			break;
+	}
+}
 
-			if ((maxA_y < minB_y) && (f1race_opposite_car[index].is_add_score == SDL_FALSE)) {
-				f1race_score++;
-				f1race_pass++;
-				f1race_opposite_car[index].is_add_score = SDL_TRUE;
-
-				if (f1race_pass == 10)
-					f1race_level++; /* level 2 */
-				else if (f1race_pass == 20)
-					f1race_level++; /* level 3 */
-				else if (f1race_pass == 30)
-					f1race_level++; /* level 4 */
-				else if (f1race_pass == 40)
-					f1race_level++; /* level 5 */
-				else if (f1race_pass == 50)
-					f1race_level++; /* level 6 */
-				else if (f1race_pass == 60)
-					f1race_level++; /* level 7 */
-				else if (f1race_pass == 70)
-					f1race_level++; /* level 8 */
-				else if (f1race_pass == 100)
-					f1race_level++; /* level 9 */
-
-				f1race_fly_charger_count++;
-				if (f1race_fly_charger_count >= 6) {
-					if (f1race_fly_count < F1RACE_MAX_FLY_COUNT) {
-						f1race_fly_charger_count = 0;
-						f1race_fly_count++;
-					} else
-						f1race_fly_charger_count--;
-				}
-			}
-		}
+static void main_loop(CONTEXT *context) {
+	SDL_Event event;
+	Uint64 counter;
+	int span;
+	Uint64 period = context->frequency;
+	F1RACE_TRACE_BEGIN(frame);
+
+	while (SDL_PollEvent(&event))
+		main_loop_event(&event);
+	Audio_Update();
+
+	counter = SDL_GetPerformanceCounter();
+	context->accumulator += (counter - context->counter) * options.tick_rate;
+	context->counter = counter;
+	if (context->accumulator > period * F1RACE_MAX_TICKS_PER_FRAME)
+		context->accumulator = period * F1RACE_MAX_TICKS_PER_FRAME; // Drop ticks after stalls instead of catching up.
+
+	Render_Begin(context->texture);
+	if (render_repaint) {
+		F1Race_Repaint();
+		render_repaint = SDL_FALSE;
+	}
+	while (context->accumulator >= period) {
+		F1RACE_TRACE_BEGIN(tick);
+		F1Race_Cyclic_Timer();
+		F1RACE_TRACE_END(tick, F1RACE_TRACE_TICK);
+		context->accumulator -= period;
+		if (options.latency)
+			Latency_Tick(SDL_GetPerformanceCounter());
 	}
+	if (f1race_state.is_crashing == 0) {
+		F1RACE_TRACE_BEGIN(render);
+		F1Race_Interpolate((double) context->accumulator / period);
+		F1Race_Render();
+		F1RACE_TRACE_END(render, F1RACE_TRACE_RENDER);
+	}
+	{
+		F1RACE_TRACE_BEGIN(submit);
+		Render_End(context->texture);
+		F1RACE_TRACE_END(submit, F1RACE_TRACE_SUBMIT);
+	}
+	context->presented = render_dirty;
+	if (!render_dirty) {
+		draw_skipped_frames++;
+		F1RACE_TRACE_END(frame, F1RACE_TRACE_FRAME);
+		return;
+	}
+	render_dirty = SDL_FALSE;
+	SDL_Rect rectangle;
+	rectangle.x = 0;
+	rectangle.y = 0;
+	rectangle.w = WINDOW_WIDTH;
+	rectangle.h = WINDOW_HEIGHT;
+	{
+		F1RACE_TRACE_BEGIN(copy);
+		SDL_RenderCopy(render, context->texture, &rectangle, NULL);
+		F1RACE_TRACE_END(copy, F1RACE_TRACE_COPY);
+	}
+	span = (startup.first_frame == 0) ? Profile_Begin("SDL_RenderPresent", NULL) : -1;
+	{
+		F1RACE_TRACE_BEGIN(present);
+		SDL_RenderPresent(render);
+		F1RACE_TRACE_END(present, F1RACE_TRACE_PRESENT);
+	}
+	Profile_End(span);
+	if (startup.first_frame == 0)
+		startup.first_frame = SDL_GetPerformanceCounter();
+	draw_frame.draw_calls++;
+	Render_Frame_End();
+	if (options.latency)
+		Latency_Present(SDL_GetPerformanceCounter());
+	F1RACE_TRACE_END(frame, F1RACE_TRACE_FRAME);
 }
 
-static void F1Race_Framemove(void) {
-	Sint16 shift;
-	Sint16 max;
-	Sint16 index;
+#ifdef __EMSCRIPTEN__
+static void main_loop_emscripten(void *arguments) {
+	main_loop(arguments);
+}
+#else
+/* Handles input as soon as it arrives while waiting for the next frame or tick deadline, whichever comes first. */
+static void main_loop_wait(CONTEXT *context) {
+	SDL_Event event;
+	Uint64 counter;
+	Uint64 deadline = context->counter + context->frequency / context->refresh_rate;
+	Uint64 tick = context->counter + (context->frequency - context->accumulator) / options.tick_rate;
+	Uint32 timeout;
 
-	f1race_player_car_fly_duration++;
-	if (f1race_player_car_fly_duration == F1RACE_PLAYER_CAR_FLY_FRAME_COUNT)
-		f1race_player_is_car_fly = SDL_FALSE;
+	if (context->vsync && context->presented)
+		return; // SDL_RenderPresent() paces frames, events are polled every refresh.
+	if (tick < deadline)
+		deadline = tick;
 
-	shift = F1RACE_PLAYER_CAR_SHIFT;
-	if (f1race_key_up_pressed) {
-		if (f1race_player_car.pos_y - shift < F1RACE_DISPLAY_START_Y)
-			shift = f1race_player_car.pos_y - F1RACE_DISPLAY_START_Y - 1;
-		if (f1race_player_is_car_fly == SDL_FALSE)
-			f1race_player_car.pos_y -= shift;
+	while (!exit_main_loop) {
+		counter = SDL_GetPerformanceCounter();
+		if (counter >= deadline)
+			break;
+		timeout = (Uint32) ((deadline - counter) * 1000 / context->frequency);
+		if (timeout == 0)
+			break;
+		if (SDL_WaitEventTimeout(&event, timeout))
+			main_loop_event(&event);
 	}
+}
+#endif
 
-	if (f1race_key_down_pressed) {
-		max = f1race_player_car.pos_y + f1race_player_car.dy;
-		if (max + shift > F1RACE_DISPLAY_END_Y)
-			shift = F1RACE_DISPLAY_END_Y - max;
-		if (f1race_player_is_car_fly == SDL_FALSE)
-			f1race_player_car.pos_y += shift;
+static int F1Race_Replay_Play(const char *path) {
+	F1RACE_FILE_MAPPING mapping;
+	F1RACE_REPLAY replay;
+	Uint8 input;
+	Uint32 events;
+	Uint32 games = 0;
+	Sint16 best_score = 0;
+	Uint64 start, finish;
+	double seconds;
+
+	if (!F1Race_File_Map(&mapping, path)) {
+		fprintf(stderr, "Replay Error: cannot map \"%s\".\n", path);
+		return EXIT_FAILURE;
+	}
+	if (!F1Race_Replay_Open(&replay, mapping.data, mapping.size)) {
+		fprintf(stderr, "Replay Error: \"%s\" is not a valid replay.\n", path);
+		F1Race_File_Unmap(&mapping);
+		return EXIT_FAILURE;
 	}
 
-	if (f1race_key_right_pressed) {
-		max = f1race_player_car.pos_x + f1race_player_car.dx;
-		if (max + shift > F1RACE_ROAD_2_END_X)
-			shift = F1RACE_ROAD_2_END_X - max;
-		f1race_player_car.pos_x += shift;
+	start = SDL_GetPerformanceCounter();
+	F1Race_Seed(&f1race_state, replay.seed);
+	F1Race_Init(&f1race_state);
+	while (F1Race_Replay_Next(&replay, &input)) {
+		events = F1Race_Step(&f1race_state, input);
+		if (f1race_state.score > best_score)
+			best_score = f1race_state.score;
+		if (events & F1RACE_EVENT_NEW_GAME)
+			games++;
 	}
+	finish = SDL_GetPerformanceCounter();
+	seconds = (double) (finish - start) / SDL_GetPerformanceFrequency();
+
+	printf("seed: %llu\n", (unsigned long long) replay.seed);
+	printf("ticks: %u\n", replay.tick);
+	printf("games finished: %u\n", games);
+	printf("best score: %d\n", best_score);
+	printf("final score: %d, level: %d\n", f1race_state.score, f1race_state.level);
+	printf("time: %.3f ms, %.0f ticks/sec\n", seconds * 1000.0, (seconds > 0) ? replay.tick / seconds : 0.0);
+
+	F1Race_File_Unmap(&mapping);
+	return EXIT_SUCCESS;
+}
+
+static const char *Render_Bench_Backend_Name(BACKEND backend) {
+	return (backend == BACKEND_FRAMEBUFFER) ? "framebuffer" : "sdl";
+}
 
-	if (f1race_key_left_pressed) {
-		if (f1race_player_car.pos_x - shift < F1RACE_ROAD_0_START_X)
-			shift = f1race_player_car.pos_x - F1RACE_ROAD_0_START_X - 1;
-		f1race_player_car.pos_x -= shift;
+/*
+ * Plays the same seeded frames as main_loop() at the default refresh rate, a tick every few frames and
+ * interpolated frames in between, into a hidden window without vsync. CPU time is of the whole process.
+ */
+static void Render_Bench_Run(SDL_Window *window, const char *video, int driver, BACKEND backend, Uint32 frames) {
+	SDL_RendererInfo info;
+	SDL_Rect rectangle;
+	Uint32 random = (Uint32) options.seed | 1;
+	Uint32 frame, phase;
+	Uint64 start, finish;
+	clock_t cpu_start, cpu_finish;
+	double seconds;
+
+	SDL_GetRenderDriverInfo(driver, &info);
+	render = SDL_CreateRenderer(window, driver, SDL_RENDERER_TARGETTEXTURE);
+	if (render == NULL) {
+		printf("%-10s %-12s %-12s not available: %s\n", video, info.name, Render_Bench_Backend_Name(backend),
+			SDL_GetError());
+		return;
 	}
+	options.backend = backend;
+	Texture_Load();
+	F1Race_Framebuffer_Init(&framebuffer, framebuffer_pixels, TEXTURE_WIDTH, TEXTURE_HEIGHT);
+	SDL_zero(draw_frame);
+	SDL_zero(draw_max);
+	draw_total_calls = draw_total_state_changes = draw_total_commands = 0;
+	draw_frames = draw_skipped_frames = 0;
+	draw_submitted_state = ~0ull;
+	draw_color = F1RACE_DRAW_RGB(0, 0, 0);
+	render_dirty = SDL_TRUE;
+	f1race_input = 0;
+	F1Race_Seed(&f1race_state, options.seed);
+	F1Race_Configure(&f1race_state, &options.traffic);
+	F1Race_Set_Rules(&f1race_state, options.rules);
+	F1Race_Init(&f1race_state);
+	f1race_state_previous = f1race_state;
+	F1Race_View_Current();
+	rectangle.x = 0;
+	rectangle.y = 0;
+	rectangle.w = WINDOW_WIDTH;
+	rectangle.h = WINDOW_HEIGHT;
 
-	for (index = 0; index < F1RACE_OPPOSITE_CAR_COUNT; index++) {
-		if (f1race_opposite_car[index].is_empty == SDL_FALSE) {
-			f1race_opposite_car[index].pos_y += f1race_opposite_car[index].speed;
-			if (f1race_opposite_car[index].pos_y > (F1RACE_DISPLAY_END_Y + f1race_opposite_car[index].dy))
-				f1race_opposite_car[index].is_empty = SDL_TRUE;
+	start = SDL_GetPerformanceCounter();
+	cpu_start = clock();
+	Render_Begin(textures[TEXTURE_SCREEN]);
+	Render_Clear();
+	F1Race_Main();
+	Render_End(textures[TEXTURE_SCREEN]);
+	for (frame = 0; frame < frames; frame++) {
+		phase = frame % F1RACE_BENCH_FRAMES_PER_TICK;
+		Render_Begin(textures[TEXTURE_SCREEN]);
+		if (phase == 0) {
+			random ^= random << 13;
+			random ^= random >> 17;
+			random ^= random << 5;
+			if (random % 8 == 0)
+				f1race_input = (random >> 8) & F1RACE_INPUT_DIRECTIONS;
+			if (random % 64 == 1)
+				f1race_input |= F1RACE_INPUT_FLY;
+			F1Race_Cyclic_Timer();
+		}
+		if (f1race_state.is_crashing == 0) {
+			F1Race_Interpolate((double) phase / F1RACE_BENCH_FRAMES_PER_TICK);
+			F1Race_Render();
 		}
+		Render_End(textures[TEXTURE_SCREEN]);
+		if (!render_dirty) {
+			draw_skipped_frames++;
+			continue;
+		}
+		render_dirty = SDL_FALSE;
+		SDL_RenderCopy(render, textures[TEXTURE_SCREEN], &rectangle, NULL);
+		SDL_RenderPresent(render);
+		draw_frame.draw_calls++;
+		Render_Frame_End();
 	}
+	finish = SDL_GetPerformanceCounter();
+	cpu_finish = clock();
+	seconds = (double) (finish - start) / SDL_GetPerformanceFrequency();
 
-	if (f1race_player_is_car_fly != SDL_FALSE) {
-		shift = F1RACE_PLAYER_CAR_FLY_SHIFT;
-		if (f1race_player_car.pos_y - shift < F1RACE_DISPLAY_START_Y)
-			shift = f1race_player_car.pos_y - F1RACE_DISPLAY_START_Y - 1;
-		f1race_player_car.pos_y -= shift;
-	} else
-		F1Race_CollisionCheck();
+	printf("%-10s %-12s %-12s %12.0f %14.3f %12.2f %10u\n", video, info.name, Render_Bench_Backend_Name(backend),
+		frames / seconds, (double) (cpu_finish - cpu_start) * 1000.0 / CLOCKS_PER_SEC / frames,
+		(double) (draw_total_calls + draw_frame.draw_calls) / frames, draw_frames);
 
-	F1Race_New_Opposite_Car();
+	Texture_Unload();
+	SDL_DestroyRenderer(render);
+	render = NULL;
 }
 
-/* === END LOGIC CODE === */
+/* Every render driver with both backends under the default and the "dummy" video drivers, then exits. */
+static int F1Race_Bench_Render(Uint32 frames) {
+	static const BACKEND backends[] = { BACKEND_SDL, BACKEND_FRAMEBUFFER };
+	static const char *videos[] = { NULL, "dummy" };
+	char video[32], tested[32] = "";
+	SDL_Window *window;
+	int index, driver, backend;
 
-static void F1Race_Cyclic_Timer(void) {
-	if (f1race_is_crashing == SDL_FALSE) {
-		F1Race_Framemove();
-		F1Race_Render();
-	} else {
-		f1race_crashing_count_down--;
-		if (f1race_crashing_count_down >= 40)
-			F1Race_Render_Player_Car_Crash();
-		else {
-			if (f1race_crashing_count_down == 39)
-				Music_Play(MUSIC_GAMEOVER, 0);
-			F1Race_Show_Game_Over_Screen();
+	if (SDL_Init(0) != 0) {
+		fprintf(stderr, "SDL_Init Error: %s.\n", SDL_GetError());
+		return EXIT_FAILURE;
+	}
+	Pack_Load();
+	printf("%-10s %-12s %-12s %12s %14s %12s %10s\n", "video", "renderer", "backend", "frames/sec", "cpu ms/frame",
+		"calls/frame", "presented");
+	for (index = 0; index < (int) (sizeof(videos) / sizeof(videos[0])); index++) {
+		if (SDL_VideoInit(videos[index]) != 0) {
+			printf("%-10s not available: %s\n", (videos[index] != NULL) ? videos[index] : "default", SDL_GetError());
+			continue;
 		}
-		if (f1race_crashing_count_down <= 0) {
-			f1race_is_crashing = SDL_FALSE;
-			f1race_is_new_game = SDL_TRUE;
-			F1Race_Main();
+		SDL_strlcpy(video, SDL_GetCurrentVideoDriver(), sizeof(video));
+		if (!strcmp(video, tested)) {
+			SDL_VideoQuit();
+			continue; // The default driver is "dummy" already.
 		}
+		SDL_strlcpy(tested, video, sizeof(tested));
+		window = SDL_CreateWindow("F1 Race", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+			WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_HIDDEN);
+		if (window == NULL) {
+			printf("%-10s not available: %s\n", video, SDL_GetError());
+			SDL_VideoQuit();
+			continue;
+		}
+		for (driver = 0; driver < SDL_GetNumRenderDrivers(); driver++)
+			for (backend = 0; backend < (int) (sizeof(backends) / sizeof(backends[0])); backend++)
+				Render_Bench_Run(window, video, driver, backends[backend], frames);
+		SDL_DestroyWindow(window);
+		SDL_VideoQuit();
 	}
+	Pack_Unload();
+	SDL_Quit();
+	return EXIT_SUCCESS;
 }
 
-static void main_loop(SDL_Texture *texture) {
-	SDL_Event event;
-	while (SDL_PollEvent(&event)) {
-		switch (event.type) {
-			case SDL_QUIT:
-				exit_main_loop = SDL_TRUE;
-				break;
-			case SDL_KEYDOWN:
-				F1Race_Keyboard_Key_Handler(event.key.keysym.sym, SDL_TRUE);
-				break;
-			case SDL_KEYUP:
-				F1Race_Keyboard_Key_Handler(event.key.keysym.sym, SDL_FALSE);
-				break;
-		}
-	}
-	SDL_SetRenderTarget(render, texture);
-	F1Race_Cyclic_Timer();
-	SDL_SetRenderTarget(render, NULL);
-	SDL_Rect rectangle;
-	rectangle.x = 0;
-	rectangle.y = 0;
-	rectangle.w = WINDOW_WIDTH;
-	rectangle.h = WINDOW_HEIGHT;
-	SDL_RenderCopy(render, texture, &rectangle, NULL);
-	SDL_RenderPresent(render);
+static void Options_Usage(const char *program) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  --seed N             seed of the traffic generator (default: current time)\n"
+		"  --tick-rate N        game logic ticks per second, rendering follows the display (default: %d)\n"
+		"  --backend NAME       renderer backend: \"sdl\" or CPU-side \"framebuffer\" (default: sdl)\n"
+		"  --draw-stats         print draw commands, draw calls and state changes per frame on exit\n"
+		"  --latency            print key-down to state change and to present latency percentiles on exit\n"
+		"  --startup-stats      print time to the first frame and to audio readiness on exit\n"
+		"  --audio-buffer N     audio buffer size in samples, a power of two from %d to %d (default: %d)\n"
+		"  --profile FILE       write startup and shutdown phase timings as JSON on exit, \"-\" is the standard output,\n"
+		"                       the F1RACE_PROFILE environment variable does the same\n"
+#if defined(F1RACE_TRACING)
+		"  --trace FILE         write frame, logic, render and present timings as Chrome trace JSON on exit\n"
+		"                       and print their latency percentiles\n"
+#endif
+		"  --record FILE        record the seed and every input change into a replay file\n"
+		"  --replay FILE        play a replay file through the game logic as fast as possible and exit\n"
+		"  --bench-render N     render N seeded frames with every video driver, render driver and backend, print\n"
+		"                       frames/sec, CPU time and draw calls per frame and exit\n"
+		"  --traffic L,C[,D[,S]]  stress traffic: L lanes up to %d, C cars up to %d, D rows of road above the screen,\n"
+		"                       S new car attempts per tick, also for \"--bench-render\", more cars need a build with\n"
+		"                       \"make TRAFFIC=-DF1RACE_OPPOSITE_CAR_COUNT=N\"\n"
+		"  --rules FILE         car types, spawn weights and levels, also for \"--bench-render\" (default: classic)\n"
+		"  --state FILE         game state file F5 saves and F9 loads (default: %s)\n"
+		"  --load FILE          start from a game state file saved with the same rules\n"
+		"  --pack FILE          asset pack made by \"f1race-packer\" (default: %s if present)\n",
+		program, F1RACE_TICK_RATE, F1RACE_AUDIO_MIN_BUFFER, F1RACE_AUDIO_MAX_BUFFER, F1RACE_AUDIO_BUFFER,
+		F1RACE_MAX_LANES, F1RACE_OPPOSITE_CAR_COUNT, F1RACE_STATE_PATH, F1RACE_PACK_PATH);
 }
 
-#ifdef __EMSCRIPTEN__
-static void main_loop_emscripten(void *arguments) {
-	CONTEXT_EMSCRIPTEN *context = arguments;
-	main_loop(context->texture);
+/* The classic rules changed by the settings of a file, compiled once for all games of the session. */
+static SDL_bool Options_Load_Rules(const char *path) {
+	F1RACE_FILE_MAPPING mapping;
+	F1RACE_RULES rules;
+	int line;
+
+	if (!F1Race_File_Map(&mapping, path)) {
+		fprintf(stderr, "Rules Error: cannot map \"%s\".\n", path);
+		return SDL_FALSE;
+	}
+	F1Race_Rules_Classic(&rules);
+	line = F1Race_Rules_Parse(&rules, (const char *) mapping.data, mapping.size);
+	F1Race_File_Unmap(&mapping);
+	if (line != 0) {
+		fprintf(stderr, "Rules Error: \"%s\", line %d is wrong.\n", path, line);
+		return SDL_FALSE;
+	}
+	if (!F1Race_Rules_Compile(&options_rules, &rules)) {
+		fprintf(stderr, "Rules Error: \"%s\" cannot be played.\n", path);
+		return SDL_FALSE;
+	}
+	options.rules = &options_rules;
+	return SDL_TRUE;
 }
+
+static SDL_bool Options_Parse(int argc, char *argv[]) {
+	int index;
+	F1RACE_TRAFFIC_ERROR error;
+
+	options.seed = (Uint64) time(0);
+	options.tick_rate = F1RACE_TICK_RATE;
+	options.audio_buffer = F1RACE_AUDIO_BUFFER;
+	F1Race_Traffic_Classic(&options.traffic);
+	options.rules = F1Race_Ruleset_Classic();
+	options.state = F1RACE_STATE_PATH;
+
+	for (index = 1; index < argc; index++) {
+		if (!strcmp(argv[index], "--seed") && index + 1 < argc)
+			options.seed = strtoull(argv[++index], NULL, 10);
+		else if (!strcmp(argv[index], "--tick-rate") && index + 1 < argc) {
+			options.tick_rate = (Uint32) strtoul(argv[++index], NULL, 10);
+			if (options.tick_rate == 0 || options.tick_rate > F1RACE_MAX_TICK_RATE)
+				return SDL_FALSE;
+		} else if (!strcmp(argv[index], "--backend") && index + 1 < argc) {
+			index++;
+			if (!strcmp(argv[index], "sdl"))
+				options.backend = BACKEND_SDL;
+			else if (!strcmp(argv[index], "framebuffer"))
+				options.backend = BACKEND_FRAMEBUFFER;
+			else
+				return SDL_FALSE;
+		} else if (!strcmp(argv[index], "--draw-stats"))
+			options.draw_stats = SDL_TRUE;
+		else if (!strcmp(argv[index], "--latency"))
+			options.latency = SDL_TRUE;
+		else if (!strcmp(argv[index], "--startup-stats"))
+			options.startup_stats = SDL_TRUE;
+		else if (!strcmp(argv[index], "--audio-buffer") && index + 1 < argc) {
+			options.audio_buffer = (Uint32) strtoul(argv[++index], NULL, 10);
+			if (options.audio_buffer < F1RACE_AUDIO_MIN_BUFFER || options.audio_buffer > F1RACE_AUDIO_MAX_BUFFER ||
+					(options.audio_buffer & (options.audio_buffer - 1)) != 0)
+				return SDL_FALSE;
+		}
+		else if (!strcmp(argv[index], "--record") && index + 1 < argc)
+			options.record = argv[++index];
+		else if (!strcmp(argv[index], "--replay") && index + 1 < argc)
+			options.replay = argv[++index];
+		else if (!strcmp(argv[index], "--bench-render") && index + 1 < argc) {
+			options.bench_render = (Uint32) strtoul(argv[++index], NULL, 10);
+			if (options.bench_render == 0)
+				return SDL_FALSE;
+		} else if (!strcmp(argv[index], "--pack") && index + 1 < argc)
+			options.pack = argv[++index];
+		else if (!strcmp(argv[index], "--profile") && index + 1 < argc)
+			options.profile = argv[++index];
+#if defined(F1RACE_TRACING)
+		else if (!strcmp(argv[index], "--trace") && index + 1 < argc)
+			options.trace = argv[++index];
 #endif
+		else if (!strcmp(argv[index], "--traffic") && index + 1 < argc) {
+			error = F1Race_Traffic_Parse(&options.traffic, argv[++index]);
+			if (error != F1RACE_TRAFFIC_OK) {
+				fprintf(stderr, "Wrong traffic: %s, %s, this build takes 1-%d lanes, 1-%d cars, depth 0-%d and "
+					"1-%d spawns.\n", argv[index], F1Race_Traffic_Error(error), F1RACE_MAX_LANES, F1RACE_OPPOSITE_CAR_COUNT,
+					F1RACE_MAX_TRAFFIC_DEPTH, F1RACE_MAX_LANES);
+				if (error == F1RACE_TRAFFIC_CARS)
+					fprintf(stderr, "Build with TRAFFIC=-DF1RACE_OPPOSITE_CAR_COUNT=N for more cars.\n");
+				return SDL_FALSE;
+			}
+		} else if (!strcmp(argv[index], "--state") && index + 1 < argc)
+			options.state = argv[++index];
+		else if (!strcmp(argv[index], "--load") && index + 1 < argc)
+			options.load = argv[++index];
+		else if (!strcmp(argv[index], "--rules") && index + 1 < argc) {
+			if (!Options_Load_Rules(argv[++index]))
+				return SDL_FALSE;
+		} else
+			return SDL_FALSE;
+	}
+	if (options.record && options.traffic.lane_spacing) {
+		fprintf(stderr, "Replays keep the seed only and play the classic traffic, \"--record\" ignores \"--traffic\".\n");
+		F1Race_Traffic_Classic(&options.traffic);
+	}
+	if (options.record && options.rules != F1Race_Ruleset_Classic()) {
+		fprintf(stderr, "Replays keep the seed only and play the classic rules, \"--record\" ignores \"--rules\".\n");
+		options.rules = F1Race_Ruleset_Classic();
+	}
+	if (options.record && options.load) {
+		fprintf(stderr, "Replays start from the seed, \"--record\" ignores \"--load\".\n");
+		options.load = NULL;
+	}
+	return SDL_TRUE;
+}
+
+int main(int argc, char *argv[]) {
+	int span;
+
+	startup.start = SDL_GetPerformanceCounter();
+	if (!Options_Parse(argc, argv)) {
+		Options_Usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	F1Race_Rewind_Init(&f1race_rewind, f1race_rewind_states, F1RACE_REWIND_STATES);
 
-int main(SDL_UNUSED int argc, SDL_UNUSED char *argv[]) {
-	srand(time(0));
+	if (options.replay)
+		return F1Race_Replay_Play(options.replay);
+	if (options.bench_render)
+		return F1Race_Bench_Render(options.bench_render);
 
-	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) != 0) {
+	if (options.profile == NULL)
+		options.profile = SDL_getenv("F1RACE_PROFILE");
+	profile.enabled = (options.profile != NULL && options.profile[0] != '\0') ? SDL_TRUE : SDL_FALSE;
+	profile.main_thread = SDL_ThreadID();
+
+	span = Profile_Begin("SDL_Init", NULL);
+	if (SDL_Init(SDL_INIT_VIDEO) != 0) {
 		fprintf(stderr, "SDL_Init Error: %s.\n", SDL_GetError());
 		return EXIT_FAILURE;
 	}
+	Profile_End(span);
 
 #if defined(_WIN32)
 	SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
 #endif
 	SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+	span = Profile_Begin("Pack_Load", NULL);
+	Pack_Load();
+	Profile_End(span);
+	Audio_Start(); // Slow audio devices must not delay the window and the first frame.
 
+	span = Profile_Begin("SDL_CreateWindow", NULL);
 	SDL_Window *window = SDL_CreateWindow("F1 Race",
 		SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, WINDOW_WIDTH, WINDOW_HEIGHT,
 		SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
@@ -1150,61 +2238,114 @@ int main(SDL_UNUSED int argc, SDL_UNUSED char *argv[]) {
 		fprintf(stderr, "SDL_CreateWindow Error: %s.\n", SDL_GetError());
 		return EXIT_FAILURE;
 	}
+	Profile_End(span);
 
-	SDL_Surface *icon = SDL_LoadBMP("assets/GAME_F1RACE_ICON.bmp");
-	if (icon == NULL)
-		fprintf(stderr, "SDL_LoadBMP Error: %s.\n", SDL_GetError());
-	else {
+	static const ASSET icon_asset = ASSET_BMP(GAME_F1RACE_ICON);
+	span = Profile_Begin("SDL_SetWindowIcon", icon_asset.path);
+	SDL_Surface *icon = Asset_Load_Bitmap(&icon_asset);
+	if (icon != NULL) {
 		SDL_SetColorKey(icon, SDL_TRUE, SDL_MapRGB(icon->format, 36, 227, 113)); // Icon transparent mask.
 		SDL_SetWindowIcon(window, icon);
 		SDL_FreeSurface(icon);
 	}
+	Profile_End(span);
 
-	render = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
+	span = Profile_Begin("SDL_CreateRenderer", NULL);
+	render = SDL_CreateRenderer(window, -1,
+		SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE | SDL_RENDERER_PRESENTVSYNC);
 	if (render == NULL) {
 		fprintf(stderr, "SDL_CreateRenderer Error: %s.\n", SDL_GetError());
+		Audio_Unload();
 		SDL_DestroyWindow(window);
 		SDL_Quit();
 		return EXIT_FAILURE;
 	}
+	Profile_End(span);
 
+	span = Profile_Begin("Texture_Load", NULL);
 	Texture_Load();
+	Profile_End(span);
+
+	if (options.record && !F1Race_Replay_Record_Open(&f1race_recorder, options.record, options.seed))
+		fprintf(stderr, "Replay Error: cannot create \"%s\".\n", options.record);
+
+	F1Race_Framebuffer_Init(&framebuffer, framebuffer_pixels, TEXTURE_WIDTH, TEXTURE_HEIGHT);
+	Render_Begin(textures[TEXTURE_SCREEN]);
+	Render_Clear();
+	F1Race_Seed(&f1race_state, options.seed);
+	F1Race_Configure(&f1race_state, &options.traffic);
+	F1Race_Set_Rules(&f1race_state, options.rules);
+	F1Race_Init(&f1race_state);
+	if (options.load)
+		F1Race_Load_State(options.load);
+	f1race_state_previous = f1race_state;
+	F1Race_View_Current();
+	span = Profile_Begin("F1Race_Main", NULL);
+	F1Race_Main();
+	Render_End(textures[TEXTURE_SCREEN]);
+	Profile_End(span);
 
-	int result = Mix_Init(MIX_INIT_OGG);
-	if (result != MIX_INIT_OGG) {
-		fprintf(stderr, "Mix_Init Error: %s.\n", Mix_GetError());
-		return EXIT_FAILURE;
+#if defined(F1RACE_TRACING)
+	if (options.trace) {
+		F1Race_Trace_Init(&trace);
+		f1race_trace = &trace;
 	}
-	if (Mix_OpenAudio(44100, AUDIO_S16SYS, 1, 4096) == -1) {
-		fprintf(stderr, "Mix_OpenAudio Error: %s.\n", Mix_GetError());
-		return EXIT_FAILURE;
-	}
-
-	Music_Load();
+#endif
 
-	SDL_SetRenderTarget(render, textures[TEXTURE_SCREEN]);
-	SDL_RenderClear(render);
-	F1Race_Main();
-	SDL_SetRenderTarget(render, NULL);
+	CONTEXT context;
+	SDL_RendererInfo renderer_info;
+	SDL_DisplayMode display_mode;
+	context.texture = textures[TEXTURE_SCREEN];
+	context.frequency = SDL_GetPerformanceFrequency();
+	context.counter = SDL_GetPerformanceCounter();
+	context.accumulator = 0;
+	context.presented = SDL_FALSE;
+	context.vsync = (SDL_GetRendererInfo(render, &renderer_info) == 0 &&
+		(renderer_info.flags & SDL_RENDERER_PRESENTVSYNC)) ? SDL_TRUE : SDL_FALSE;
+	context.refresh_rate = (SDL_GetCurrentDisplayMode(0, &display_mode) == 0 && display_mode.refresh_rate > 0) ?
+		display_mode.refresh_rate : F1RACE_DEFAULT_REFRESH_RATE;
 
 #ifndef __EMSCRIPTEN__
 	while (!exit_main_loop) {
-		main_loop(textures[TEXTURE_SCREEN]);
-		SDL_Delay(F1RACE_TIMER_ELAPSE); // 10 FPS.
+		main_loop(&context);
+		main_loop_wait(&context);
 	}
 #else
-	CONTEXT_EMSCRIPTEN context;
-	context.texture = textures[TEXTURE_SCREEN];
-	emscripten_set_main_loop_arg(main_loop_emscripten, &context, 10, 1); // 10 FPS.
+	emscripten_set_main_loop_arg(main_loop_emscripten, &context, 0, 1); // Display refresh rate.
 #endif
 
-	Mix_CloseAudio();
-	Music_Unload();
+	F1Race_Replay_Record_Close(&f1race_recorder);
+	if (options.latency)
+		Latency_Report();
+	if (options.draw_stats)
+		Render_Report();
+#if defined(F1RACE_TRACING)
+	if (options.trace) {
+		f1race_trace = NULL;
+		F1Race_Trace_Report(&trace, stderr);
+		if (!F1Race_Trace_Write_Chrome(&trace, options.trace))
+			fprintf(stderr, "Trace Error: cannot write \"%s\".\n", options.trace);
+	}
+#endif
+
+	Audio_Unload();
+	if (options.startup_stats)
+		Startup_Report();
+	span = Profile_Begin("Texture_Unload", NULL);
 	Texture_Unload();
+	Profile_End(span);
+	span = Profile_Begin("Pack_Unload", NULL);
+	Pack_Unload();
+	Profile_End(span);
 
+	span = Profile_Begin("SDL_Quit", NULL);
 	SDL_DestroyRenderer(render);
 	SDL_DestroyWindow(window);
 	SDL_Quit();
+	Profile_End(span);
+
+	if (profile.enabled)
+		Profile_Write(options.profile);
 
 	return EXIT_SUCCESS;
 }